@@ -1,29 +1,71 @@
+OBJECTS="src/graph.o src/graph_builder.o src/geometry.o src/mapped_file.o src/output.o src/cells.o src/search.o src/query_service.o src/hub_labels.o src/graph_registry.o"
+
 if [[ "$1" == "graph" ]]
 then
-	clang++ src/graph.cpp -c -o src/graph.o -std=c++17 -O3
+	clang++ src/graph.cpp -c -o src/graph.o -std=c++17 -O3 -fno-math-errno
+	clang++ src/graph_builder.cpp -c -o src/graph_builder.o -std=c++17 -O3
+	clang++ src/geometry.cpp -c -o src/geometry.o -std=c++17 -O3
+	clang++ src/mapped_file.cpp -c -o src/mapped_file.o -std=c++17 -O3
+	clang++ src/output.cpp -c -o src/output.o -std=c++17 -O3
+	clang++ src/cells.cpp -c -o src/cells.o -std=c++17 -O3
+	clang++ src/search.cpp -c -o src/search.o -std=c++17 -O3
+	clang++ src/query_service.cpp -c -o src/query_service.o -std=c++17 -O3
+	clang++ src/hub_labels.cpp -c -o src/hub_labels.o -std=c++17 -O3
+	clang++ src/graph_registry.cpp -c -o src/graph_registry.o -std=c++17 -O3
 fi
 
 if [[ "$1" == "make" ]]
 then
-	clang++ src/make_graph.cpp -o make -std=c++17 -O3 /usr/local/lib/libbz2.a /usr/local/lib/libexpat.a /usr/local/lib/libz.a src/graph.o
+	clang++ src/make_graph.cpp -o make -std=c++17 -O3 /usr/local/lib/libbz2.a /usr/local/lib/libexpat.a /usr/local/lib/libz.a $OBJECTS
 fi
 
 if [[ "$1" == "run" ]]
 then
-	clang++ src/run.cpp -o run -std=c++17 -O3 src/graph.o
+	clang++ src/run.cpp -o run -std=c++17 -O3 -pthread $OBJECTS
+fi
+
+if [[ "$1" == "cells" ]]
+then
+	clang++ src/make_cells.cpp -o cells -std=c++17 -O3 $OBJECTS
+fi
+
+if [[ "$1" == "dump" ]]
+then
+	clang++ src/dump.cpp -o dump -std=c++17 -O3 $OBJECTS
+fi
+
+if [[ "$1" == "labels" ]]
+then
+	clang++ src/make_labels.cpp -o labels -std=c++17 -O3 $OBJECTS
+fi
+
+if [[ "$1" == "regions" ]]
+then
+	clang++ src/make_regions.cpp -o regions -std=c++17 -O3 -pthread $OBJECTS
+fi
+
+if [[ "$1" == "serve" ]]
+then
+	clang++ src/serve.cpp -o serve -std=c++17 -O3 -pthread $OBJECTS
+fi
+
+if [[ "$1" == "bench" ]]
+then
+	clang++ src/bench_heuristic.cpp -o bench -std=c++17 -O3 $OBJECTS
+	clang++ src/bench_search.cpp -o bench_search -std=c++17 -O3 $OBJECTS
 fi
 
 if [[ "$1" == "factor" ]]
 then
-	clang++ src/factor.cpp -o factor -std=c++17 -O3 src/graph.o
+	clang++ src/factor.cpp -o factor -std=c++17 -O3 -pthread $OBJECTS
 fi
 
 if [[ "$1" == "results" ]]
 then
-	clang++ src/results.cpp -o results -std=c++17 -O3 src/graph.o
+	clang++ src/results.cpp -o results -std=c++17 -O3 -pthread $OBJECTS
 fi
 
 if [[ "$1" == "speed" ]]
 then
-	clang++ src/average_speed.cpp -o speed -std=c++17 -O3 /usr/local/lib/libbz2.a /usr/local/lib/libexpat.a /usr/local/lib/libz.a
+	clang++ src/average_speed.cpp -o speed -std=c++17 -O3 -pthread /usr/local/lib/libbz2.a /usr/local/lib/libexpat.a /usr/local/lib/libz.a $OBJECTS
 fi
\ No newline at end of file
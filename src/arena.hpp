@@ -0,0 +1,71 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+//append-only storage in large fixed blocks: one allocation per block, no reallocation copies
+template<typename T>
+class Arena
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Arena holds plain records only");
+
+private:
+	constexpr static std::size_t BLOCK_BYTES = 1u << 24;
+	constexpr static std::size_t BLOCK_SIZE = BLOCK_BYTES / sizeof(T) > 0 ? BLOCK_BYTES / sizeof(T) : 1;
+
+	std::vector<std::unique_ptr<T[]>> blocks;
+	std::size_t count;
+
+public:
+	Arena() : blocks(), count(0u) {}
+
+	void push_back(const T &value)
+	{
+		if (count == blocks.size() * BLOCK_SIZE)
+			blocks.emplace_back(new T[BLOCK_SIZE]);
+		blocks[count / BLOCK_SIZE][count % BLOCK_SIZE] = value;
+		count++;
+	}
+
+	const T& operator[](std::size_t i) const
+	{
+		return blocks[i / BLOCK_SIZE][i % BLOCK_SIZE];
+	}
+
+	template<typename F>
+	void for_each(F f) const
+	{
+		for(std::size_t b = 0u; b < blocks.size(); ++b)
+		{
+			const std::size_t n = b + 1 < blocks.size() ? BLOCK_SIZE : count - b * BLOCK_SIZE;
+			const T *block = blocks[b].get();
+			for(std::size_t i = 0u; i < n; ++i)
+				f(block[i]);
+		}
+	}
+
+	std::size_t size() const noexcept
+	{
+		return count;
+	}
+
+	std::size_t memory_usage() const noexcept
+	{
+		return blocks.size() * BLOCK_SIZE * sizeof(T);
+	}
+
+	void clear() noexcept
+	{
+		blocks.clear();
+		blocks.shrink_to_fit();
+		count = 0u;
+	}
+};
+
+template<typename T> constexpr std::size_t Arena<T>::BLOCK_BYTES;
+template<typename T> constexpr std::size_t Arena<T>::BLOCK_SIZE;
+
+#endif //ARENA_HPP
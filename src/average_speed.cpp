@@ -1,125 +1,482 @@
 #include <osmium/io/any_input.hpp>
-#include <osmium/visitor.hpp>
 #include <osmium/geom/haversine.hpp>
 #include <osmium/geom/coordinates.hpp>
-#include <osmium/handler.hpp>
-#include <osmium/handler/node_locations_for_ways.hpp>
-#include <osmium/index/map/all.hpp>
+#include <osmium/index/map/flex_mem.hpp>
 
-#include <iostream>
-#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
 
-typedef osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location> index_neg_type;
-typedef osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
+#include "graph.hpp"
+#include "geometry.hpp"
+#include "highway.hpp"
+#include "output.hpp"
 
-typedef osmium::handler::NodeLocationsForWays<index_pos_type, index_neg_type> location_handler_type;
+typedef osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> index_type;
 
-class Handler : public location_handler_type
+//log-spaced bins, 16 per doubling: percentiles within 4.5%, and threads merge by adding counts
+class Histogram
 {
 private:
-    index_pos_type index_pos;
-    index_neg_type index_neg;
-    std::map<osmium::object_id_type, std::uint32_t> link_counter;
-    std::uint32_t count;
-    double total;
+    constexpr static int BINS_PER_DOUBLING = 16;
+    constexpr static int MIN_EXPONENT = -16;
+    constexpr static int MAX_EXPONENT = 32;
+    //bin 0 holds zero and everything below 2^MIN_EXPONENT
+    constexpr static int N_BINS = (MAX_EXPONENT - MIN_EXPONENT) * BINS_PER_DOUBLING + 1;
+
+    std::vector<std::uint64_t> bins;
+    std::uint64_t count;
+    double sum;
+    double min;
+    double max;
+
+    static int bin_of(double x)
+    {
+        if (!(x > std::ldexp(1.0, MIN_EXPONENT)))
+            return 0;
+        const int b = 1 + static_cast<int>((std::log2(x) - MIN_EXPONENT) * BINS_PER_DOUBLING);
+        return std::min(b, N_BINS - 1);
+    }
+
+    static double lower_bound(int b)
+    {
+        return b == 0 ? 0.0 : std::exp2(MIN_EXPONENT + static_cast<double>(b - 1) / BINS_PER_DOUBLING);
+    }
+
+public:
+    Histogram() : bins(N_BINS, 0u), count(0u), sum(0.0), min(0.0), max(0.0) {}
+
+    void add(double x)
+    {
+        min = count == 0u ? x : std::min(min, x);
+        max = count == 0u ? x : std::max(max, x);
+        bins[bin_of(x)]++;
+        count++;
+        sum += x;
+    }
+
+    void merge(const Histogram &other)
+    {
+        if (other.count == 0u)
+            return;
+        min = count == 0u ? other.min : std::min(min, other.min);
+        max = count == 0u ? other.max : std::max(max, other.max);
+        for(int b = 0; b < N_BINS; ++b)
+            bins[b] += other.bins[b];
+        count += other.count;
+        sum += other.sum;
+    }
+
+    //geometric middle of the bin holding the requested rank, clamped to the observed range
+    double percentile(double p) const
+    {
+        const std::uint64_t rank = std::max<std::uint64_t>(1u, static_cast<std::uint64_t>(std::ceil(p * count)));
+        std::uint64_t seen = 0u;
+
+        for(int b = 0; b < N_BINS; ++b)
+        {
+            seen += bins[b];
+            if (seen >= rank)
+            {
+                const double middle = b == 0 ? min : std::sqrt(lower_bound(b) * lower_bound(b + 1));
+                return std::min(max, std::max(min, middle));
+            }
+        }
+        return max;
+    }
+
+    void write_json(BufferedWriter &w) const
+    {
+        w.put("{\"count\":");
+        w.put(static_cast<std::uint64_t>(count));
+        if (count > 0u)
+        {
+            static const struct { const char *key; double p; } PERCENTILES[] =
+                {{"p10", 0.1}, {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}};
+
+            w.put(",\"mean\":");
+            w.put(sum / count, 3);
+            w.put(",\"min\":");
+            w.put(min, 3);
+            w.put(",\"max\":");
+            w.put(max, 3);
+            for(const auto &p : PERCENTILES)
+            {
+                w.put(",\"");
+                w.put(p.key);
+                w.put("\":");
+                w.put(percentile(p.p), 3);
+            }
+
+            //non-empty bins only, as [lower bound, count]
+            w.put(",\"histogram\":[");
+            bool first = true;
+            for(int b = 0; b < N_BINS; ++b)
+            {
+                if (bins[b] == 0u)
+                    continue;
+                w.put(first ? "[" : ",[");
+                w.put(lower_bound(b), 6);
+                w.put(',');
+                w.put(static_cast<std::uint64_t>(bins[b]));
+                w.put(']');
+                first = false;
+            }
+            w.put(']');
+        }
+        w.put('}');
+    }
+};
+
+struct ClassStatistics
+{
+    Histogram speed; //km/h
+    Histogram length; //m
+    Histogram time; //s
+
+    void add(double length_m, double speed_kmh)
+    {
+        length.add(length_m);
+        if (speed_kmh > 0.0)
+        {
+            speed.add(speed_kmh);
+            time.add(3.6 * length_m / speed_kmh);
+        }
+    }
+
+    void merge(const ClassStatistics &other)
+    {
+        speed.merge(other.speed);
+        length.merge(other.length);
+        time.merge(other.time);
+    }
+};
+
+typedef std::map<std::string, ClassStatistics> ClassMap;
+
+//way buffers handed from the reader to the workers; bounded so reading cannot run far ahead
+class BufferQueue
+{
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<osmium::memory::Buffer> buffers;
+    std::size_t capacity;
+    bool closed;
 
 public:
+    BufferQueue(std::size_t c) : mutex(), changed(), buffers(), capacity(c), closed(false) {}
+
+    void push(osmium::memory::Buffer &&buffer)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return buffers.size() < capacity; });
+        buffers.push_back(std::move(buffer));
+        changed.notify_all();
+    }
+
+    bool pop(osmium::memory::Buffer &buffer)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return !buffers.empty() || closed; });
+        if (buffers.empty())
+            return false;
+        buffer = std::move(buffers.front());
+        buffers.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+};
+
+static void put_json_string(BufferedWriter &w, const std::string &s)
+{
+    w.put('"');
+    for(char c : s)
+    {
+        if (c == '"' || c == '\\')
+            w.put('\\');
+        if (static_cast<unsigned char>(c) >= 0x20)
+            w.put(c);
+    }
+    w.put('"');
+}
 
-    Handler() : 
-        index_pos(), index_neg(),
-        location_handler_type(index_pos, index_neg), 
-        link_counter(),
-        count(0u), total(0.0)
-    {}
+static void write_classes(BufferedWriter &w, const ClassMap &classes)
+{
+    w.put("\"classes\":{");
+    for(ClassMap::const_iterator it = classes.cbegin(); it != classes.cend(); ++it)
+    {
+        if (it != classes.cbegin())
+            w.put(',');
+        put_json_string(w, it->first);
+        w.put(":{\"speed_kmh\":");
+        it->second.speed.write_json(w);
+        w.put(",\"length_m\":");
+        it->second.length.write_json(w);
+        w.put(",\"time_s\":");
+        it->second.time.write_json(w);
+        w.put('}');
+    }
+    w.put('}');
+}
 
-    void way(const osmium::Way &way) 
+static void add_ways(const osmium::memory::Buffer &buffer, const index_type &index, ClassMap &classes)
+{
+    for(auto it = buffer.begin<osmium::Way>(); it != buffer.end<osmium::Way>(); ++it)
     {
-        const osmium::TagList &tags = way.tags();
+        const osmium::TagList &tags = it->tags();
+        if (!is_routable(tags))
+            continue;
 
-        if(tags.has_key("highway") && 
-            !tags.has_tag("highway", "path") && 
-            !tags.has_tag("highway", "pedestrian"))
+        double length = 0.0;
+        osmium::Location prev;
+        for(const osmium::NodeRef &node : it->nodes())
+        {
+            const osmium::Location l = node.ref() > 0 ? index.get_noexcept(node.positive_ref()) : osmium::Location();
+            if (prev.valid() && l.valid())
+                length += osmium::geom::haversine::distance(osmium::geom::Coordinates(prev), osmium::geom::Coordinates(l));
+            if (l.valid())
+                prev = l;
+        }
+
+        classes[tags.get_value_by_key("highway")].add(length, way_speed(tags));
+    }
+}
+
+//a single pass over the file: nodes fill the location index on this thread, way buffers go to the workers
+static void pbf_statistics(const char *filename, std::size_t threads, BufferedWriter &w)
+{
+    index_type index;
+    BufferQueue queue(4 * threads);
+    std::vector<ClassMap> partial(threads);
+    std::vector<std::thread> pool;
+
+    for(std::size_t t = 0u; t < threads; ++t)
+    {
+        pool.emplace_back([&, t]()
         {
-            
-            const char *speed_str = tags.get_value_by_key("maxspeed");
-            double speed = 30.0; //default speed in km/h
-            if (!speed_str) //not provided (majority)
+            osmium::memory::Buffer buffer;
+            while (queue.pop(buffer))
+                add_ways(buffer, index, partial[t]);
+        });
+    }
+
+    //sorted files put all nodes before ways; stray later nodes would race with the workers, so they are skipped
+    std::uint64_t late_nodes = 0u;
+    bool ways_started = false;
+
+    //the workers must be joined however reading ends
+    std::exception_ptr failure;
+    try
+    {
+        osmium::io::Reader reader(filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
+        while (osmium::memory::Buffer buffer = reader.read())
+        {
+            for(auto it = buffer.begin<osmium::Node>(); it != buffer.end<osmium::Node>(); ++it)
+            {
+                if (ways_started)
+                    late_nodes++;
+                else if (it->id() > 0)
+                    index.set(it->positive_id(), it->location());
+            }
+
+            if (buffer.begin<osmium::Way>() != buffer.end<osmium::Way>())
             {
-                if (tags.has_tag("highway", "motorway"))
-                    speed = 120.0;
-                else if (tags.has_tag("highway", "motorway_link"))
-                    speed = 120.0;
-                else if (tags.has_tag("highway", "trunk"))
-                    speed = 100.0;
-                else if (tags.has_tag("highway", "trunk_link"))
-                    speed = 100.0;
-                else if (tags.has_tag("highway", "primary"))
-                    speed = 90.0;
-                else if (tags.has_tag("highway", "primary_link"))
-                    speed = 90.0;
-                else if (tags.has_tag("highway", "secondary"))
-                    speed = 70.0;
-                else if (tags.has_tag("highway", "secondary_link"))
-                    speed = 70.0;
-                else if (tags.has_tag("highway", "tertiary"))
-                    speed = 60.0;
-                else if (tags.has_tag("highway", "tertiary_link"))
-                    speed = 60.0;
-                else if (tags.has_tag("highway", "unclassified"))
-                    speed = 50.0;
-                else if (tags.has_tag("highway", "residential"))
-                    speed = 30.0;
-                else if (tags.has_tag("highway", "living_street"))
-                    speed = 10.0;
-                else if(tags.has_tag("highway", "service"))
-                    speed = 30.0;
-                else if (tags.has_tag("highway", "track"))
-                    speed = 30.0;
+                //sparse lookups binary search the entries, which arrive in file order
+                if (!ways_started)
+                    index.sort();
+                ways_started = true;
+                queue.push(std::move(buffer));
             }
-            else if (const char *ptr = std::strstr(speed_str, "mph"))
-                speed = std::atof(speed_str) * 1.60934;
-            else if (const char *ptr = std::strstr(speed_str, "knots"))
-                speed = std::atof(speed_str) * 1.852;
-            else if (std::strncmp(speed_str, "none", std::strlen(speed_str)) == 0)
-                speed = 180.0;
-            else if (std::strncmp(speed_str, "walk", std::strlen(speed_str)) == 0)
-                speed = 5.0;
-            else //speed in km/h
-                speed = std::atof(speed_str);
-
-            total += speed;
-            count++;
         }
+        reader.close();
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+    queue.close();
+
+    for(std::thread &t : pool)
+        t.join();
+    if (failure)
+        std::rethrow_exception(failure);
+
+    ClassMap classes;
+    for(const ClassMap &p : partial)
+    {
+        for(const auto &c : p)
+            classes[c.first].merge(c.second);
     }
 
-    void output()
+    w.put("\"source\":\"pbf\",\"unit\":\"way\",\"late_nodes\":");
+    w.put(late_nodes);
+    w.put(',');
+    write_classes(w, classes);
+}
+
+static void graph_statistics(const char *filename, std::size_t threads, BufferedWriter &w)
+{
+    const Graph graph(filename);
+    const ShapeStore shapes((std::string(filename) + ".geom").c_str());
+    const std::size_t n = graph.vertex_count();
+
+    std::vector<ClassStatistics> partial(threads);
+    std::vector<std::vector<std::uint64_t>> degrees(threads);
+    std::vector<std::thread> pool;
+
+    //vertex ranges per thread; edge length follows the stored shape when there is one
+    for(std::size_t t = 0u; t < threads; ++t)
     {
-        std::cout << (total / count);
+        pool.emplace_back([&, t]()
+        {
+            std::vector<Graph::Location> scratch;
+
+            for(Graph::index_t v = t * n / threads; v < (t + 1) * n / threads; ++v)
+            {
+                const Graph::EdgeRange range = graph.out_edges(v);
+                if (degrees[t].size() <= range.size())
+                    degrees[t].resize(range.size() + 1, 0u);
+                degrees[t][range.size()]++;
+
+                for(const Graph::Edge &e : range)
+                {
+                    Graph::Location from = graph.vertex_location(v);
+                    double length = 0.0;
+                    auto add_point = [&](const Graph::Location &l)
+                    {
+                        length += osmium::geom::haversine::distance(
+                            osmium::geom::Coordinates(from.lon, from.lat), osmium::geom::Coordinates(l.lon, l.lat));
+                        from = l;
+                    };
+
+                    const Graph::shape_t shape = (e.shape & ~Graph::SHAPE_REVERSED) < shapes.shape_count() ?
+                        e.shape : Graph::NO_SHAPE;
+                    unpack_edge(shapes, graph.vertex_location(v), graph.vertex_location(e.destination), shape,
+                        scratch, add_point);
+
+                    //costs are metres over km/h
+                    partial[t].add(length, e.cost > 0.0 ? length / e.cost : 0.0);
+                }
+            }
+        });
     }
 
-}; 
+    //strongly connected components run meanwhile on this thread
+    const std::vector<std::size_t> components = graph.component_sizes();
+
+    for(std::thread &t : pool)
+        t.join();
+
+    ClassStatistics all;
+    std::vector<std::uint64_t> degree;
+    for(std::size_t t = 0u; t < threads; ++t)
+    {
+        all.merge(partial[t]);
+        if (degree.size() < degrees[t].size())
+            degree.resize(degrees[t].size(), 0u);
+        for(std::size_t d = 0u; d < degrees[t].size(); ++d)
+            degree[d] += degrees[t][d];
+    }
 
-int main(int argc, char **argv) 
+    //component sizes bucketed by powers of two
+    std::vector<std::uint64_t> size_buckets;
+    std::size_t largest = 0u;
+    for(std::size_t size : components)
+    {
+        std::size_t bucket = 0u;
+        while ((std::size_t(2) << bucket) <= size)
+            bucket++;
+        if (size_buckets.size() <= bucket)
+            size_buckets.resize(bucket + 1, 0u);
+        size_buckets[bucket]++;
+        largest = std::max(largest, size);
+    }
+
+    w.put("\"source\":\"graph\",\"unit\":\"edge\",\"vertices\":");
+    w.put(static_cast<std::uint64_t>(n));
+    w.put(",\"edges\":");
+    w.put(static_cast<std::uint64_t>(graph.edge_count()));
+    w.put(',');
+    write_classes(w, {{"all", all}});
+
+    w.put(",\"out_degree\":[");
+    for(std::size_t d = 0u; d < degree.size(); ++d)
+    {
+        w.put(d > 0u ? ",[" : "[");
+        w.put(static_cast<std::uint64_t>(d));
+        w.put(',');
+        w.put(degree[d]);
+        w.put(']');
+    }
+
+    w.put("],\"components\":{\"count\":");
+    w.put(static_cast<std::uint64_t>(components.size()));
+    w.put(",\"largest\":");
+    w.put(static_cast<std::uint64_t>(largest));
+    w.put(",\"sizes\":[");
+    for(std::size_t b = 0u; b < size_buckets.size(); ++b)
+    {
+        w.put(b > 0u ? ",[" : "[");
+        w.put(static_cast<std::uint64_t>(std::size_t(1) << b));
+        w.put(',');
+        w.put(size_buckets[b]);
+        w.put(']');
+    }
+    w.put("]}");
+}
+
+int main(int argc, char **argv)
 {
-    if (argc != 2) 
+    if (argc < 2 || argc > 4)
     {
-        std::cerr << "Argument expected: file_input,.";
+        std::cerr << "1/2/3 arguments expected: file_input (.dat graph or OSM file), (optional : file_output.json), (optional : threads)";
         return EXIT_FAILURE;
     }
 
-    try 
+    const std::string input(argv[1]);
+    const bool is_graph = input.size() > 4 && input.compare(input.size() - 4, 4, ".dat") == 0;
+    const std::size_t threads = std::max<std::size_t>(1u,
+        argc == 4 ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency());
+
+    try
     {
-        Handler hnd;
-        osmium::io::Reader reader1(argv[1], osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
-        osmium::apply(reader1, hnd);
+        std::unique_ptr<BufferedWriter> file_out(argc >= 3 ? new BufferedWriter(argv[2]) : nullptr);
+        BufferedWriter console(std::cout);
+        BufferedWriter &w = file_out ? *file_out : console;
+
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+        w.put('{');
+        if (is_graph)
+            graph_statistics(argv[1], threads, w);
+        else
+            pbf_statistics(argv[1], threads, w);
+        const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+        w.put(",\"threads\":");
+        w.put(static_cast<std::uint64_t>(threads));
+        w.put(",\"seconds\":");
+        w.put(duration.count(), 3);
+        w.put("}\n");
 
-        hnd.output();
-        
         return EXIT_SUCCESS;
-    } 
-    catch (const std::exception &e) 
+    }
+    catch (const std::exception &e)
     {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
-}
\ No newline at end of file
+}
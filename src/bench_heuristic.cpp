@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <osmium/geom/haversine.hpp>
+#include "graph.hpp"
+
+//the great circle arc over the same speed bound: not admissible, since the bound is calibrated on the shorter
+//chords, so it is only timed and compared against here, never searched with
+static Graph::cost_t haversine_estimate(const Graph &graph, Graph::index_t v1, Graph::index_t v2)
+{
+    const Graph::Location &l1 = graph.vertex_location(v1), &l2 = graph.vertex_location(v2);
+    return osmium::geom::haversine::distance(osmium::geom::Coordinates(l1.lon, l1.lat),
+        osmium::geom::Coordinates(l2.lon, l2.lat)) / 1000.0 / graph.heuristic_speed();
+}
+
+//walks every adjacency once per goal, as a search relaxing each edge would
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::cerr << "1/2 arguments expected: file_input, (optional : number of goals)";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t goals = argc == 3 ? std::strtoul(argv[2], nullptr, 10) : 16u;
+
+    if (goals == 0u)
+    {
+        std::cerr << "Enter a positive number of goals.";
+        return EXIT_FAILURE;
+    }
+
+    Graph graph(argv[1]);
+    const std::size_t n = graph.vertex_count();
+
+    if (n == 0u)
+    {
+        std::cerr << "Empty graph.";
+        return EXIT_FAILURE;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start;
+    std::chrono::duration<double> haversine_time(0.0), batch_time(0.0);
+    std::vector<Graph::index_t> adjacency;
+    std::vector<Graph::cost_t> batch;
+    double haversine_sum = 0.0, batch_sum = 0.0, tightest = 1.0;
+    std::size_t relaxations = 0u;
+
+    for(std::size_t g = 0u; g < goals; ++g)
+    {
+        const Graph::index_t goal = static_cast<Graph::index_t>(g * n / goals);
+
+        start = std::chrono::high_resolution_clock::now();
+        for(Graph::index_t v = 0u; v < n; ++v)
+        {
+            for(const Graph::Edge &e : graph.out_edges(v))
+                haversine_sum += haversine_estimate(graph, e.destination, goal);
+        }
+        haversine_time += std::chrono::high_resolution_clock::now() - start;
+
+        start = std::chrono::high_resolution_clock::now();
+        for(Graph::index_t v = 0u; v < n; ++v)
+        {
+            const Graph::EdgeRange range = graph.out_edges(v);
+            adjacency.clear();
+            for(const Graph::Edge &e : range)
+                adjacency.push_back(e.destination);
+            batch.resize(adjacency.size());
+            graph.estimate_batch(adjacency.data(), adjacency.size(), goal, batch.data());
+            for(Graph::cost_t c : batch)
+                batch_sum += c;
+        }
+        batch_time += std::chrono::high_resolution_clock::now() - start;
+
+        relaxations += graph.edge_count();
+    }
+
+    //the chord bound must never exceed haversine; report how close it stays
+    for(Graph::index_t v = 0u; v < n; v += std::max<std::size_t>(1u, n / 100000u))
+    {
+        const Graph::cost_t h = haversine_estimate(graph, v, 0u);
+        if (h > 0.0)
+            tightest = std::min(tightest, graph.estimate(v, 0u) / h);
+    }
+
+    std::cout << relaxations << " relaxations over " << goals << " goals." << std::endl;
+    std::cout << "haversine: " << 1e9 * haversine_time.count() / relaxations << " ns/relaxation (sum " <<
+        haversine_sum << ")" << std::endl;
+    std::cout << "chord batch: " << 1e9 * batch_time.count() / relaxations << " ns/relaxation (sum " <<
+        batch_sum << ")" << std::endl;
+    std::cout << "chord/haversine at least " << tightest << "." << std::endl;
+
+    return EXIT_SUCCESS;
+}
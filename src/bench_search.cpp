@@ -0,0 +1,218 @@
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include "graph.hpp"
+#include "search.hpp"
+
+typedef std::pair<Graph::cost_t, Graph::index_t> Entry;
+typedef std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> ReferenceQueue;
+
+//the hand-written loops the kernel replaced, kept as the baseline
+static Graph::cost_t reference_dijkstra(const Graph &graph, Graph::index_t start, Graph::index_t goal)
+{
+    std::vector<Graph::cost_t> cost_so_far(graph.vertex_count(), std::numeric_limits<Graph::cost_t>::infinity());
+    std::vector<Graph::index_t> parent(graph.vertex_count(), Graph::NO_INDEX);
+    ReferenceQueue frontier;
+
+    frontier.push(Entry(0.0, start));
+    cost_so_far[start] = 0.0;
+
+    while (!frontier.empty())
+    {
+        const Graph::index_t current = frontier.top().second;
+        frontier.pop();
+
+        if (current == goal)
+            return cost_so_far[goal];
+
+        for(const Graph::Edge &edge : graph.out_edges(current))
+        {
+            const Graph::cost_t new_cost = cost_so_far[current] + edge.cost;
+            if (new_cost < cost_so_far[edge.destination])
+            {
+                cost_so_far[edge.destination] = new_cost;
+                parent[edge.destination] = current;
+                frontier.push(Entry(new_cost, edge.destination));
+            }
+        }
+    }
+
+    return std::numeric_limits<Graph::cost_t>::infinity();
+}
+
+static Graph::cost_t reference_astar(const Graph &graph, Graph::index_t start, Graph::index_t goal)
+{
+    std::vector<Graph::cost_t> cost_so_far(graph.vertex_count(), std::numeric_limits<Graph::cost_t>::infinity());
+    std::vector<Graph::index_t> parent(graph.vertex_count(), Graph::NO_INDEX);
+    std::unique_ptr<Graph::cost_t[]> estimate_of(new Graph::cost_t[graph.vertex_count()]);
+    std::vector<Graph::index_t> pending;
+    std::vector<Graph::cost_t> batch;
+    ReferenceQueue frontier;
+
+    frontier.push(Entry(0.0, start));
+    cost_so_far[start] = 0.0;
+
+    while (!frontier.empty())
+    {
+        const Graph::index_t current = frontier.top().second;
+        frontier.pop();
+
+        if (current == goal)
+            return cost_so_far[goal];
+
+        pending.clear();
+        for(const Graph::Edge &edge : graph.out_edges(current))
+        {
+            if (cost_so_far[edge.destination] == std::numeric_limits<Graph::cost_t>::infinity())
+                pending.push_back(edge.destination);
+        }
+        batch.resize(pending.size());
+        graph.estimate_batch(pending.data(), pending.size(), goal, batch.data());
+        for(std::size_t i = 0u; i < pending.size(); ++i)
+            estimate_of[pending[i]] = batch[i];
+
+        for(const Graph::Edge &edge : graph.out_edges(current))
+        {
+            const Graph::cost_t new_cost = cost_so_far[current] + edge.cost;
+            if (new_cost < cost_so_far[edge.destination])
+            {
+                cost_so_far[edge.destination] = new_cost;
+                parent[edge.destination] = current;
+                frontier.push(Entry(new_cost + estimate_of[edge.destination], edge.destination));
+            }
+        }
+    }
+
+    return std::numeric_limits<Graph::cost_t>::infinity();
+}
+
+//the kernel as Graph and QueryService run it: one workspace, reset over just the vertices each query reached;
+//the reference loops fill graph-sized arrays per query, as the repo's loops did
+template<typename Queue, typename Heuristic, typename Visitor>
+static Graph::cost_t kernel(const Graph &graph, Graph::index_t start, Graph::index_t goal,
+    const Heuristic &heuristic, Visitor &visitor)
+{
+    SearchSpace &space = thread_search_space(graph.vertex_count());
+    search<Queue>(graph, start, space, heuristic, StopAtTarget{goal}, visitor);
+    const Graph::cost_t cost = space.cost[goal];
+    space.reset();
+    return cost;
+}
+
+//the same with a graph-sized workspace per query, which is what the reuse saves
+template<typename Queue, typename Heuristic, typename Visitor>
+static Graph::cost_t fresh_kernel(const Graph &graph, Graph::index_t start, Graph::index_t goal,
+    const Heuristic &heuristic, Visitor &visitor)
+{
+    SearchSpace space(graph.vertex_count());
+    search<Queue>(graph, start, space, heuristic, StopAtTarget{goal}, visitor);
+    return space.cost[goal];
+}
+
+struct Variant
+{
+    const char *name;
+    std::function<Graph::cost_t(Graph::index_t, Graph::index_t, CountingVisitor*)> run;
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::cerr << "1/2/3 arguments expected: file_input, (optional : number of queries), (optional : landmarks)";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100u;
+    const std::size_t n_landmarks = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 8u;
+
+    const Graph graph(argv[1]);
+    const std::size_t n = graph.vertex_count();
+
+    if (n == 0u || queries == 0u)
+    {
+        std::cerr << "Need a non-empty graph and a positive number of queries.";
+        return EXIT_FAILURE;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    const ReverseView reverse(graph);
+    const Landmarks landmarks(graph, reverse, n_landmarks);
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    std::cout << landmarks.vertices().size() << " landmarks in " << duration.count() << "s, " <<
+        ((landmarks.memory_usage() + reverse.memory_usage()) >> 20) << " MiB." << std::endl;
+
+    //counted runs are separate from timed runs, so timings use the empty visitor
+    const Variant variants[] =
+    {
+        {"reference dijkstra", [&](Graph::index_t s, Graph::index_t t, CountingVisitor*)
+            { return reference_dijkstra(graph, s, t); }},
+        {"kernel dijkstra", [&](Graph::index_t s, Graph::index_t t, CountingVisitor *c)
+            { NullVisitor v; return c ? kernel<BinaryHeap>(graph, s, t, ZeroHeuristic(), *c) :
+                kernel<BinaryHeap>(graph, s, t, ZeroHeuristic(), v); }},
+        {"kernel dijkstra, fresh space", [&](Graph::index_t s, Graph::index_t t, CountingVisitor *c)
+            { NullVisitor v; return c ? fresh_kernel<BinaryHeap>(graph, s, t, ZeroHeuristic(), *c) :
+                fresh_kernel<BinaryHeap>(graph, s, t, ZeroHeuristic(), v); }},
+        {"kernel dijkstra 4-heap", [&](Graph::index_t s, Graph::index_t t, CountingVisitor *c)
+            { NullVisitor v; return c ? kernel<QuaternaryHeap>(graph, s, t, ZeroHeuristic(), *c) :
+                kernel<QuaternaryHeap>(graph, s, t, ZeroHeuristic(), v); }},
+        {"reference astar", [&](Graph::index_t s, Graph::index_t t, CountingVisitor*)
+            { return reference_astar(graph, s, t); }},
+        {"kernel astar", [&](Graph::index_t s, Graph::index_t t, CountingVisitor *c)
+            { NullVisitor v; GreatCircleHeuristic h(graph, t);
+                return c ? kernel<BinaryHeap>(graph, s, t, h, *c) : kernel<BinaryHeap>(graph, s, t, h, v); }},
+        {"kernel alt", [&](Graph::index_t s, Graph::index_t t, CountingVisitor *c)
+            { NullVisitor v; LandmarkHeuristic h(landmarks, t);
+                return c ? kernel<BinaryHeap>(graph, s, t, h, *c) : kernel<BinaryHeap>(graph, s, t, h, v); }},
+    };
+    const std::size_t n_variants = sizeof(variants) / sizeof(variants[0]);
+
+    std::mt19937_64 random(1u);
+    std::uniform_int_distribution<Graph::index_t> pick(0u, static_cast<Graph::index_t>(n - 1));
+    std::vector<std::pair<Graph::index_t, Graph::index_t>> pairs(queries);
+    for(auto &p : pairs)
+        p = {pick(random), pick(random)};
+
+    std::vector<Graph::cost_t> expected(queries);
+    for(std::size_t q = 0u; q < queries; ++q)
+        expected[q] = reference_dijkstra(graph, pairs[q].first, pairs[q].second);
+
+    //variants take turns on each query, so machine noise spreads evenly over them
+    std::vector<double> time(n_variants, 0.0);
+    std::vector<std::size_t> mismatches(n_variants, 0u);
+    for(std::size_t q = 0u; q < queries; ++q)
+    {
+        for(std::size_t i = 0u; i < n_variants; ++i)
+        {
+            start = std::chrono::high_resolution_clock::now();
+            const Graph::cost_t c = variants[i].run(pairs[q].first, pairs[q].second, nullptr);
+            duration = std::chrono::high_resolution_clock::now() - start;
+            time[i] += duration.count();
+
+            //same optimum, possibly along an equal-cost path summed in another order
+            if (std::abs(c - expected[q]) > 1e-9 * expected[q])
+                mismatches[i]++;
+        }
+    }
+
+    std::cout << "variant\ttime/query\tsettled/query\tmismatches" << std::endl;
+
+    for(std::size_t i = 0u; i < n_variants; ++i)
+    {
+        CountingVisitor counter;
+        for(std::size_t q = 0u; q < queries; ++q)
+            variants[i].run(pairs[q].first, pairs[q].second, &counter);
+
+        std::cout << variants[i].name << '\t' << time[i] / queries << "s (" << time[0] / time[i] << "x)\t";
+        if (counter.settled_count > 0u)
+            std::cout << counter.settled_count / queries;
+        else
+            std::cout << '-';
+        std::cout << '\t' << mismatches[i] << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
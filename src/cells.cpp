@@ -0,0 +1,777 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+#include "cells.hpp"
+#include "geometry.hpp"
+
+constexpr std::uint32_t CellRouter::NO_CELL;
+
+//"CEL1" and "OVL1"
+static const std::uint32_t CELL_MAGIC = 0x314C4543;
+static const std::uint32_t OVERLAY_MAGIC = 0x314C564F;
+
+struct CellHeader
+{
+	std::uint32_t magic;
+	std::uint32_t number;
+	std::uint64_t n_vertices;
+	std::uint64_t n_edges;
+};
+
+typedef std::pair<Graph::cost_t, Graph::index_t> CellEntry;
+typedef std::priority_queue<CellEntry, std::vector<CellEntry>, std::greater<CellEntry>> CellQueue;
+
+//longitude scaled by the cosine of the mean latitude, so inertial cuts see roughly equal-area coordinates
+static double longitude_scale(const Graph &graph)
+{
+	double mean_lat = 0.0;
+	for(Graph::index_t v = 0u; v < graph.vertex_count(); ++v)
+		mean_lat += graph.vertex_location(v).lat;
+	return std::cos(M_PI * (mean_lat / graph.vertex_count()) / 180.0);
+}
+
+//halves set along whichever inertial cut crosses fewest of its internal edges; side must be all zero
+//on entry and is left that way
+static void bisect(const Graph &graph, const std::vector<Graph::index_t> &set, double lon_scale,
+	std::vector<std::uint8_t> &side, std::vector<Graph::index_t> &left, std::vector<Graph::index_t> &right)
+{
+	typedef Graph::index_t index_t;
+
+	//inertial cuts: north-south, east-west and both diagonals
+	static const double directions[4][2] = {{1.0, 0.0}, {0.0, 1.0}, {M_SQRT1_2, M_SQRT1_2}, {M_SQRT1_2, -M_SQRT1_2}};
+
+	std::vector<std::pair<double, index_t>> keyed, best;
+	const std::size_t half = set.size() / 2;
+	std::size_t best_cut = std::numeric_limits<std::size_t>::max();
+
+	for(const double *d : directions)
+	{
+		keyed.clear();
+		for(index_t v : set)
+		{
+			const Graph::Location &l = graph.vertex_location(v);
+			keyed.push_back({l.lon * lon_scale * d[0] + l.lat * d[1], v});
+		}
+		std::nth_element(keyed.begin(), keyed.begin() + half, keyed.end());
+
+		for(std::size_t i = 0u; i < keyed.size(); ++i)
+			side[keyed[i].second] = i < half ? 1u : 2u;
+
+		//only edges inside the set count, the rest are already cut
+		std::size_t cut = 0u;
+		for(index_t v : set)
+		{
+			for(const Graph::Edge &e : graph.out_edges(v))
+			{
+				if (side[e.destination] != 0u && side[e.destination] != side[v])
+					cut++;
+			}
+		}
+
+		if (cut < best_cut)
+		{
+			best_cut = cut;
+			best.swap(keyed);
+		}
+	}
+
+	for(index_t v : set)
+		side[v] = 0u;
+
+	left.clear();
+	right.clear();
+	left.reserve(half);
+	right.reserve(set.size() - half);
+	for(std::size_t i = 0u; i < best.size(); ++i)
+		(i < half ? left : right).push_back(best[i].second);
+}
+
+std::vector<std::uint32_t> partition_graph(const Graph &graph, std::size_t max_cell_vertices, std::size_t &n_cells)
+{
+	typedef Graph::index_t index_t;
+	const std::size_t n = graph.vertex_count();
+	std::vector<std::uint32_t> cell(n, 0u);
+	std::vector<std::uint8_t> side(n, 0u);
+	n_cells = 0u;
+
+	if (n == 0u)
+		return cell;
+	max_cell_vertices = std::max<std::size_t>(max_cell_vertices, 1u);
+	const double lon_scale = longitude_scale(graph);
+
+	std::vector<std::vector<index_t>> pending(1);
+	pending.back().resize(n);
+	std::iota(pending.back().begin(), pending.back().end(), 0u);
+
+	while (!pending.empty())
+	{
+		const std::vector<index_t> set = std::move(pending.back());
+		pending.pop_back();
+
+		if (set.size() <= max_cell_vertices)
+		{
+			for(index_t v : set)
+				cell[v] = static_cast<std::uint32_t>(n_cells);
+			n_cells++;
+			continue;
+		}
+
+		std::vector<index_t> left, right;
+		bisect(graph, set, lon_scale, side, left, right);
+		pending.push_back(std::move(right));
+		pending.push_back(std::move(left));
+	}
+
+	return cell;
+}
+
+std::vector<Graph::index_t> dissection_order(const Graph &graph)
+{
+	typedef Graph::index_t index_t;
+	const std::size_t n = graph.vertex_count();
+	std::vector<index_t> order;
+	order.reserve(n);
+	if (n == 0u)
+		return order;
+
+	//a handful of vertices is ordered by degree alone
+	const std::size_t SMALL_SET = 8u;
+	const double lon_scale = longitude_scale(graph);
+	std::vector<std::uint8_t> side(n, 0u);
+	enum : std::uint8_t { LEFT = 1u, RIGHT = 2u, SEPARATOR = 3u };
+	std::vector<std::uint8_t> state(n, 0u);
+
+	auto by_degree = [&graph](index_t a, index_t b)
+	{
+		return graph.out_edges(a).size() > graph.out_edges(b).size();
+	};
+
+	//breadth first over the bisection tree, so every level's separators come before the level below
+	std::deque<std::vector<index_t>> pending(1);
+	pending.back().resize(n);
+	std::iota(pending.back().begin(), pending.back().end(), 0u);
+
+	while (!pending.empty())
+	{
+		std::vector<index_t> set = std::move(pending.front());
+		pending.pop_front();
+
+		if (set.size() <= SMALL_SET)
+		{
+			std::sort(set.begin(), set.end(), by_degree);
+			order.insert(order.end(), set.begin(), set.end());
+			continue;
+		}
+
+		std::vector<index_t> left, right;
+		bisect(graph, set, lon_scale, side, left, right);
+
+		//the left ends of edges crossing the cut, either way round, separate the halves
+		for(index_t v : left)
+			state[v] = LEFT;
+		for(index_t v : right)
+			state[v] = RIGHT;
+		for(index_t v : left)
+		{
+			for(const Graph::Edge &e : graph.out_edges(v))
+			{
+				if (state[e.destination] == RIGHT)
+					state[v] = SEPARATOR;
+			}
+		}
+		for(index_t v : right)
+		{
+			for(const Graph::Edge &e : graph.out_edges(v))
+			{
+				if (state[e.destination] == LEFT)
+					state[e.destination] = SEPARATOR;
+			}
+		}
+
+		std::vector<index_t> separator, rest;
+		for(index_t v : left)
+			(state[v] == SEPARATOR ? separator : rest).push_back(v);
+		for(index_t v : left)
+			state[v] = 0u;
+		for(index_t v : right)
+			state[v] = 0u;
+
+		std::sort(separator.begin(), separator.end(), by_degree);
+		order.insert(order.end(), separator.begin(), separator.end());
+		if (!rest.empty())
+			pending.push_back(std::move(rest));
+		if (!right.empty())
+			pending.push_back(std::move(right));
+	}
+
+	return order;
+}
+
+CellStatistics write_cells(const Graph &graph, const std::vector<std::uint32_t> &cell,
+	std::size_t n_cells, const std::string &directory)
+{
+	typedef Graph::index_t index_t;
+	const std::size_t n = graph.vertex_count();
+	const Graph::cost_t INFINITE_COST = std::numeric_limits<Graph::cost_t>::infinity();
+	CellStatistics stats = {n_cells, 0u, 0u, 0u, 0u};
+
+	//members in ascending index order, which is ascending id order
+	std::vector<std::vector<index_t>> members(n_cells);
+	std::vector<index_t> local(n);
+	for(index_t v = 0u; v < n; ++v)
+	{
+		local[v] = static_cast<index_t>(members[cell[v]].size());
+		members[cell[v]].push_back(v);
+	}
+
+	std::vector<bool> boundary(n, false);
+	for(index_t v = 0u; v < n; ++v)
+	{
+		for(const Graph::Edge &e : graph.out_edges(v))
+		{
+			if (cell[e.destination] != cell[v])
+			{
+				boundary[v] = boundary[e.destination] = true;
+				stats.cut_edges++;
+			}
+		}
+	}
+
+	std::vector<CellOverlay::CellInfo> infos(n_cells);
+
+	for(std::uint32_t c = 0u; c < n_cells; ++c)
+	{
+		CellOverlay::CellInfo &info = infos[c];
+		info.min = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+		info.max = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+		info.n_vertices = members[c].size();
+
+		std::vector<Graph::id_t> ids;
+		std::vector<Graph::Location> locations;
+		std::vector<index_t> first_edge(1u, 0u);
+		std::vector<Graph::Edge> edges;
+
+		for(index_t v : members[c])
+		{
+			const Graph::Location &l = graph.vertex_location(v);
+			ids.push_back(graph.vertex_id(v));
+			locations.push_back(l);
+			info.min = {std::min(info.min.lat, l.lat), std::min(info.min.lon, l.lon)};
+			info.max = {std::max(info.max.lat, l.lat), std::max(info.max.lon, l.lon)};
+
+			for(const Graph::Edge &e : graph.out_edges(v))
+			{
+				if (cell[e.destination] == c)
+					edges.push_back({local[e.destination], e.shape, e.cost});
+			}
+			first_edge.push_back(static_cast<index_t>(edges.size()));
+		}
+		info.n_edges = edges.size();
+		stats.largest_cell = std::max<std::size_t>(stats.largest_cell, members[c].size());
+
+		std::ofstream out(directory + "/cell_" + std::to_string(c) + ".dat", std::ios::binary);
+		const CellHeader header = {CELL_MAGIC, c, ids.size(), edges.size()};
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write_array(out, ids);
+		write_array(out, locations);
+		write_array(out, first_edge);
+		write_array(out, edges);
+	}
+
+	//overlay vertices: the boundary, again in ascending id order
+	std::vector<index_t> overlay_index(n, Graph::NO_INDEX);
+	std::vector<index_t> overlay_vertices;
+	std::vector<std::vector<index_t>> cell_boundary(n_cells);
+	for(index_t v = 0u; v < n; ++v)
+	{
+		if (!boundary[v])
+			continue;
+		overlay_index[v] = static_cast<index_t>(overlay_vertices.size());
+		cell_boundary[cell[v]].push_back(static_cast<index_t>(overlay_vertices.size()));
+		overlay_vertices.push_back(v);
+	}
+	stats.boundary_vertices = overlay_vertices.size();
+
+	std::vector<std::vector<Graph::Edge>> overlay_edges(overlay_vertices.size());
+	for(index_t b = 0u; b < overlay_vertices.size(); ++b)
+	{
+		const index_t v = overlay_vertices[b];
+		for(const Graph::Edge &e : graph.out_edges(v))
+		{
+			if (cell[e.destination] != cell[v])
+				overlay_edges[b].push_back({overlay_index[e.destination], e.shape, e.cost});
+		}
+	}
+
+	//shortcuts: exact distances between boundary vertices without leaving their cell
+	std::vector<Graph::cost_t> dist(n, INFINITE_COST);
+	std::vector<index_t> touched;
+
+	for(std::uint32_t c = 0u; c < n_cells; ++c)
+	{
+		for(index_t b : cell_boundary[c])
+		{
+			CellQueue frontier;
+			std::size_t boundary_left = cell_boundary[c].size();
+			const index_t source = overlay_vertices[b];
+
+			dist[source] = 0.0;
+			touched.push_back(source);
+			frontier.push({0.0, source});
+
+			while (!frontier.empty() && boundary_left > 0u)
+			{
+				const CellEntry top = frontier.top();
+				frontier.pop();
+				if (top.first > dist[top.second])
+					continue;
+				if (boundary[top.second])
+					boundary_left--;
+
+				for(const Graph::Edge &e : graph.out_edges(top.second))
+				{
+					const Graph::cost_t d = top.first + e.cost;
+					if (cell[e.destination] == c && d < dist[e.destination])
+					{
+						if (dist[e.destination] == INFINITE_COST)
+							touched.push_back(e.destination);
+						dist[e.destination] = d;
+						frontier.push({d, e.destination});
+					}
+				}
+			}
+
+			for(index_t other : cell_boundary[c])
+			{
+				const index_t w = overlay_vertices[other];
+				if (other != b && dist[w] < INFINITE_COST)
+					overlay_edges[b].push_back({other, Graph::NO_SHAPE, dist[w]});
+			}
+
+			for(index_t v : touched)
+				dist[v] = INFINITE_COST;
+			touched.clear();
+		}
+	}
+
+	std::vector<Graph::id_t> ids;
+	std::vector<Graph::Location> locations;
+	std::vector<std::uint32_t> cells;
+	std::vector<index_t> first_edge(1u, 0u);
+	std::vector<Graph::Edge> edges;
+
+	for(index_t b = 0u; b < overlay_vertices.size(); ++b)
+	{
+		ids.push_back(graph.vertex_id(overlay_vertices[b]));
+		locations.push_back(graph.vertex_location(overlay_vertices[b]));
+		cells.push_back(cell[overlay_vertices[b]]);
+		edges.insert(edges.end(), overlay_edges[b].begin(), overlay_edges[b].end());
+		first_edge.push_back(static_cast<index_t>(edges.size()));
+		std::vector<Graph::Edge>().swap(overlay_edges[b]);
+	}
+	stats.overlay_edges = edges.size();
+
+	std::ofstream out(directory + "/overlay.dat", std::ios::binary);
+	const CellHeader header = {OVERLAY_MAGIC, static_cast<std::uint32_t>(n_cells), ids.size(), edges.size()};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	write_array(out, infos);
+	write_array(out, ids);
+	write_array(out, locations);
+	write_array(out, cells);
+	write_array(out, first_edge);
+	write_array(out, edges);
+
+	return stats;
+}
+
+CellFile::CellFile(const char *filename)
+: file(filename), n_vertices(0u),
+	ids(nullptr), locations(nullptr), first_edge(nullptr), edges(nullptr)
+{
+	CellHeader header;
+	if (!file.is_open() || file.size() < sizeof(header))
+		return;
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	const std::size_t expected = sizeof(header) + padded(header.n_vertices * sizeof(Graph::id_t)) +
+		padded(header.n_vertices * sizeof(Graph::Location)) +
+		padded((header.n_vertices + 1) * sizeof(Graph::index_t)) + padded(header.n_edges * sizeof(Graph::Edge));
+
+	if (header.magic != CELL_MAGIC || file.size() < expected)
+	{
+		file.close();
+		return;
+	}
+
+	const std::uint8_t *p = file.data() + sizeof(header);
+	n_vertices = header.n_vertices;
+	ids = read_array<Graph::id_t>(p, n_vertices);
+	locations = read_array<Graph::Location>(p, n_vertices);
+	first_edge = read_array<Graph::index_t>(p, n_vertices + 1);
+	edges = read_array<Graph::Edge>(p, header.n_edges);
+}
+
+bool CellFile::is_open() const noexcept
+{
+	return file.is_open();
+}
+
+std::size_t CellFile::vertex_count() const noexcept
+{
+	return n_vertices;
+}
+
+std::size_t CellFile::mapped_bytes() const noexcept
+{
+	return file.size();
+}
+
+Graph::index_t CellFile::index_of(Graph::id_t vertex_id) const
+{
+	const Graph::id_t *it = std::lower_bound(ids, ids + n_vertices, vertex_id);
+	return it != ids + n_vertices && *it == vertex_id ? static_cast<Graph::index_t>(it - ids) : Graph::NO_INDEX;
+}
+
+Graph::id_t CellFile::vertex_id(Graph::index_t v) const
+{
+	return ids[v];
+}
+
+const Graph::Location& CellFile::vertex_location(Graph::index_t v) const
+{
+	return locations[v];
+}
+
+Graph::EdgeRange CellFile::out_edges(Graph::index_t v) const
+{
+	return {edges + first_edge[v], edges + first_edge[v + 1]};
+}
+
+Graph::index_t CellFile::nearest(Graph::Location target) const
+{
+	Graph::index_t closest_match = Graph::NO_INDEX;
+	double minimum_difference = std::numeric_limits<double>::max();
+
+	for(Graph::index_t v = 0u; v < n_vertices; ++v)
+	{
+		const double diff = std::abs(target.lat - locations[v].lat) + std::abs(target.lon - locations[v].lon);
+		if (diff < minimum_difference)
+		{
+			closest_match = v;
+			minimum_difference = diff;
+		}
+	}
+
+	return closest_match;
+}
+
+CellOverlay::CellOverlay(const char *filename)
+: file(filename), n_cells(0u), n_boundary(0u), cells(nullptr), ids(nullptr),
+	locations(nullptr), cell_of(nullptr), first_edge(nullptr), edges(nullptr)
+{
+	CellHeader header;
+	if (!file.is_open() || file.size() < sizeof(header))
+		return;
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	const std::size_t expected = sizeof(header) + padded(header.number * sizeof(CellInfo)) +
+		padded(header.n_vertices * sizeof(Graph::id_t)) + padded(header.n_vertices * sizeof(Graph::Location)) +
+		padded(header.n_vertices * sizeof(std::uint32_t)) +
+		padded((header.n_vertices + 1) * sizeof(Graph::index_t)) + padded(header.n_edges * sizeof(Graph::Edge));
+
+	if (header.magic != OVERLAY_MAGIC || file.size() < expected)
+	{
+		file.close();
+		return;
+	}
+
+	const std::uint8_t *p = file.data() + sizeof(header);
+	n_cells = header.number;
+	n_boundary = header.n_vertices;
+	cells = read_array<CellInfo>(p, n_cells);
+	ids = read_array<Graph::id_t>(p, n_boundary);
+	locations = read_array<Graph::Location>(p, n_boundary);
+	cell_of = read_array<std::uint32_t>(p, n_boundary);
+	first_edge = read_array<Graph::index_t>(p, n_boundary + 1);
+	edges = read_array<Graph::Edge>(p, header.n_edges);
+}
+
+bool CellOverlay::is_open() const noexcept
+{
+	return file.is_open();
+}
+
+std::size_t CellOverlay::cell_count() const noexcept
+{
+	return n_cells;
+}
+
+std::size_t CellOverlay::mapped_bytes() const noexcept
+{
+	return file.size();
+}
+
+const CellOverlay::CellInfo& CellOverlay::cell_info(std::uint32_t c) const
+{
+	return cells[c];
+}
+
+Graph::index_t CellOverlay::index_of(Graph::id_t vertex_id) const
+{
+	const Graph::id_t *it = std::lower_bound(ids, ids + n_boundary, vertex_id);
+	return it != ids + n_boundary && *it == vertex_id ? static_cast<Graph::index_t>(it - ids) : Graph::NO_INDEX;
+}
+
+Graph::id_t CellOverlay::vertex_id(Graph::index_t b) const
+{
+	return ids[b];
+}
+
+const Graph::Location& CellOverlay::vertex_location(Graph::index_t b) const
+{
+	return locations[b];
+}
+
+std::uint32_t CellOverlay::vertex_cell(Graph::index_t b) const
+{
+	return cell_of[b];
+}
+
+Graph::EdgeRange CellOverlay::out_edges(Graph::index_t b) const
+{
+	return {edges + first_edge[b], edges + first_edge[b + 1]};
+}
+
+CellRouter::CellRouter(const std::string &dir)
+: directory(dir), overlay((dir + "/overlay.dat").c_str()), loaded()
+{}
+
+bool CellRouter::is_open() const noexcept
+{
+	return overlay.is_open();
+}
+
+const CellFile& CellRouter::cell(std::uint32_t c)
+{
+	std::unique_ptr<CellFile> &slot = loaded[c];
+	if (!slot)
+		slot.reset(new CellFile((directory + "/cell_" + std::to_string(c) + ".dat").c_str()));
+	return *slot;
+}
+
+bool CellRouter::snap(Graph::Location target, std::uint32_t &best_cell, Graph::index_t &best_vertex)
+{
+	//visit cells by distance to their bounding box until none can hold a closer vertex
+	std::vector<std::pair<double, std::uint32_t>> candidates;
+	for(std::uint32_t c = 0u; c < overlay.cell_count(); ++c)
+	{
+		const CellOverlay::CellInfo &info = overlay.cell_info(c);
+		candidates.push_back({box_distance(info.min, info.max, target), c});
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	double best = std::numeric_limits<double>::max();
+	best_vertex = Graph::NO_INDEX;
+
+	for(const std::pair<double, std::uint32_t> &candidate : candidates)
+	{
+		if (candidate.first >= best)
+			break;
+
+		const CellFile &cf = cell(candidate.second);
+		const Graph::index_t v = cf.nearest(target);
+		if (v == Graph::NO_INDEX)
+			continue;
+
+		const Graph::Location &l = cf.vertex_location(v);
+		const double diff = std::abs(target.lat - l.lat) + std::abs(target.lon - l.lon);
+		if (diff < best)
+		{
+			best = diff;
+			best_cell = candidate.second;
+			best_vertex = v;
+		}
+	}
+
+	return best_vertex != Graph::NO_INDEX;
+}
+
+bool CellRouter::cell_path(std::uint32_t c, Graph::id_t from_id, Graph::id_t to_id, std::vector<Step> &steps)
+{
+	//unpacks a shortcut: the steps after from_id up to and including to_id
+	const CellFile &cf = cell(c);
+	const Graph::index_t from = cf.index_of(from_id), to = cf.index_of(to_id);
+	if (from == Graph::NO_INDEX || to == Graph::NO_INDEX)
+		return false;
+
+	std::vector<Graph::cost_t> dist(cf.vertex_count(), std::numeric_limits<Graph::cost_t>::infinity());
+	std::vector<const Graph::Edge*> via(cf.vertex_count(), nullptr);
+	std::vector<Graph::index_t> parent(cf.vertex_count(), Graph::NO_INDEX);
+	CellQueue frontier;
+
+	dist[from] = 0.0;
+	frontier.push({0.0, from});
+
+	while (!frontier.empty())
+	{
+		const CellEntry top = frontier.top();
+		frontier.pop();
+		if (top.first > dist[top.second])
+			continue;
+		if (top.second == to)
+			break;
+
+		for(const Graph::Edge &e : cf.out_edges(top.second))
+		{
+			const Graph::cost_t d = top.first + e.cost;
+			if (d < dist[e.destination])
+			{
+				dist[e.destination] = d;
+				parent[e.destination] = top.second;
+				via[e.destination] = &e;
+				frontier.push({d, e.destination});
+			}
+		}
+	}
+
+	if (to != from && parent[to] == Graph::NO_INDEX)
+		return false;
+
+	const std::size_t first = steps.size();
+	for(Graph::index_t v = to; v != from; v = parent[v])
+		steps.push_back({cf.vertex_id(v), cf.vertex_location(v), via[v]->shape});
+	std::reverse(steps.begin() + first, steps.end());
+
+	return true;
+}
+
+bool CellRouter::route(Graph::Location from, Graph::Location to, Graph::cost_t &cost, std::vector<Step> &steps)
+{
+	steps.clear();
+
+	std::uint32_t source_cell = NO_CELL, target_cell = NO_CELL;
+	Graph::index_t source_local, target_local;
+	if (!snap(from, source_cell, source_local) || !snap(to, target_cell, target_local))
+		return false;
+
+	const Graph::id_t source = cell(source_cell).vertex_id(source_local);
+	const Graph::id_t target = cell(target_cell).vertex_id(target_local);
+
+	//vertices are keyed by id: only the source and target cells are searched in full,
+	//every other cell is crossed through its overlay shortcuts
+	struct Label
+	{
+		Graph::cost_t cost;
+		Graph::id_t parent;
+		std::uint32_t cell;
+		std::uint32_t shortcut_cell;
+		Graph::shape_t shape;
+		Graph::Location loc;
+	};
+
+	typedef std::pair<Graph::cost_t, Graph::id_t> IdEntry;
+	std::unordered_map<Graph::id_t, Label> labels;
+	std::priority_queue<IdEntry, std::vector<IdEntry>, std::greater<IdEntry>> frontier;
+
+	auto relax = [&](Graph::id_t id, const Label &label)
+	{
+		auto it = labels.find(id);
+		if (it == labels.end() || label.cost < it->second.cost)
+		{
+			labels[id] = label;
+			frontier.push({label.cost, id});
+		}
+	};
+
+	relax(source, {0.0, source, source_cell, NO_CELL, Graph::NO_SHAPE, cell(source_cell).vertex_location(source_local)});
+
+	while (!frontier.empty())
+	{
+		const IdEntry top = frontier.top();
+		frontier.pop();
+
+		const Label label = labels.at(top.second);
+		if (top.first > label.cost)
+			continue;
+
+		const Graph::id_t x = top.second;
+		if (x == target)
+		{
+			cost = label.cost;
+
+			for(Graph::id_t v = target; ; )
+			{
+				const Label &l = labels.at(v);
+				if (v == source)
+				{
+					steps.push_back({v, l.loc, Graph::NO_SHAPE});
+					break;
+				}
+
+				if (l.shortcut_cell == NO_CELL)
+					steps.push_back({v, l.loc, l.shape});
+				else
+				{
+					std::vector<Step> inner;
+					if (!cell_path(l.shortcut_cell, l.parent, v, inner))
+						return false;
+					steps.insert(steps.end(), inner.rbegin(), inner.rend());
+				}
+				v = l.parent;
+			}
+
+			std::reverse(steps.begin(), steps.end());
+			return true;
+		}
+
+		const bool searched_in_full = label.cell == source_cell || label.cell == target_cell;
+
+		if (searched_in_full)
+		{
+			const CellFile &cf = cell(label.cell);
+			const Graph::index_t lx = cf.index_of(x);
+
+			for(const Graph::Edge &e : cf.out_edges(lx))
+			{
+				relax(cf.vertex_id(e.destination), {label.cost + e.cost, x, label.cell, NO_CELL,
+					e.shape, cf.vertex_location(e.destination)});
+			}
+		}
+
+		const Graph::index_t b = overlay.index_of(x);
+		if (b == Graph::NO_INDEX)
+			continue;
+
+		for(const Graph::Edge &e : overlay.out_edges(b))
+		{
+			const std::uint32_t c = overlay.vertex_cell(e.destination);
+			const bool shortcut = c == label.cell;
+			if (shortcut && searched_in_full)
+				continue;
+
+			relax(overlay.vertex_id(e.destination), {label.cost + e.cost, x, c, shortcut ? c : NO_CELL,
+				e.shape, overlay.vertex_location(e.destination)});
+		}
+	}
+
+	return false;
+}
+
+std::size_t CellRouter::loaded_cells() const noexcept
+{
+	return loaded.size();
+}
+
+std::size_t CellRouter::mapped_bytes() const noexcept
+{
+	std::size_t bytes = overlay.mapped_bytes();
+	for(const auto &entry : loaded)
+		bytes += entry.second->mapped_bytes();
+	return bytes;
+}
@@ -0,0 +1,118 @@
+#ifndef CELLS_HPP
+#define CELLS_HPP
+
+#include <map>
+#include <memory>
+#include <string>
+#include "graph.hpp"
+#include "mapped_file.hpp"
+
+//balanced cells of at most the given size, split along the location axis that cuts fewest edges
+std::vector<std::uint32_t> partition_graph(const Graph&, std::size_t, std::size_t&);
+
+//every vertex, most important first: nested dissection by the same cuts, each level's separator before
+//the halves it separates
+std::vector<Graph::index_t> dissection_order(const Graph&);
+
+struct CellStatistics
+{
+	std::size_t cells;
+	std::size_t largest_cell;
+	std::size_t cut_edges;
+	std::size_t boundary_vertices;
+	std::size_t overlay_edges;
+};
+
+//writes cell_<n>.dat for every cell and overlay.dat joining their boundary vertices
+CellStatistics write_cells(const Graph&, const std::vector<std::uint32_t>&, std::size_t, const std::string&);
+
+//vertices and internal edges of one cell, mapped read-only
+class CellFile
+{
+private:
+	MappedFile file;
+	std::size_t n_vertices;
+	const Graph::id_t *ids;
+	const Graph::Location *locations;
+	const Graph::index_t *first_edge;
+	const Graph::Edge *edges;
+
+public:
+	CellFile(const char*);
+	bool is_open() const noexcept;
+	std::size_t vertex_count() const noexcept;
+	std::size_t mapped_bytes() const noexcept;
+	Graph::index_t index_of(Graph::id_t) const;
+	Graph::id_t vertex_id(Graph::index_t) const;
+	const Graph::Location& vertex_location(Graph::index_t) const;
+	Graph::EdgeRange out_edges(Graph::index_t) const;
+	Graph::index_t nearest(Graph::Location) const;
+};
+
+//boundary vertices of all cells, joined by cut edges and by exact in-cell shortcuts
+class CellOverlay
+{
+public:
+	struct CellInfo
+	{
+		Graph::Location min;
+		Graph::Location max;
+		std::uint64_t n_vertices;
+		std::uint64_t n_edges;
+	};
+
+private:
+	MappedFile file;
+	std::size_t n_cells;
+	std::size_t n_boundary;
+	const CellInfo *cells;
+	const Graph::id_t *ids;
+	const Graph::Location *locations;
+	const std::uint32_t *cell_of;
+	const Graph::index_t *first_edge;
+	const Graph::Edge *edges;
+
+public:
+	CellOverlay(const char*);
+	bool is_open() const noexcept;
+	std::size_t cell_count() const noexcept;
+	std::size_t mapped_bytes() const noexcept;
+	const CellInfo& cell_info(std::uint32_t) const;
+	Graph::index_t index_of(Graph::id_t) const;
+	Graph::id_t vertex_id(Graph::index_t) const;
+	const Graph::Location& vertex_location(Graph::index_t) const;
+	std::uint32_t vertex_cell(Graph::index_t) const;
+	Graph::EdgeRange out_edges(Graph::index_t) const;
+};
+
+//point-to-point queries that map only the overlay plus the cells the route touches
+class CellRouter
+{
+public:
+	struct Step
+	{
+		Graph::id_t id;
+		Graph::Location loc;
+		Graph::shape_t shape; //of the edge arriving at this step
+	};
+
+private:
+	constexpr static std::uint32_t NO_CELL = 0xFFFFFFFFu;
+
+	std::string directory;
+	CellOverlay overlay;
+	std::map<std::uint32_t, std::unique_ptr<CellFile>> loaded;
+
+	const CellFile& cell(std::uint32_t);
+	bool snap(Graph::Location, std::uint32_t&, Graph::index_t&);
+	bool cell_path(std::uint32_t, Graph::id_t, Graph::id_t, std::vector<Step>&);
+
+public:
+	CellRouter(const std::string&);
+	bool is_open() const noexcept;
+	bool route(Graph::Location, Graph::Location, Graph::cost_t&, std::vector<Step>&);
+	std::size_t loaded_cells() const noexcept;
+	std::size_t mapped_bytes() const noexcept;
+};
+
+#endif //CELLS_HPP
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <string>
+#include "graph.hpp"
+#include "output.hpp"
+#include "search.hpp"
+
+//writes the whole graph, or the vertices reachable from a coordinate within a travel time, in the format
+//given by the output file's extension
+int main(int argc, char **argv)
+{
+    if (argc != 3 && argc != 6)
+    {
+        std::cerr << "2/5 arguments expected: file_input, file_output .kml/.geojson/.csv/.bin/.txt, "
+            "(optional : lat, lon, minutes)";
+        return EXIT_FAILURE;
+    }
+
+    Graph graph(argv[1]);
+    const Format format = format_from_filename(argv[2]);
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    std::size_t written = 0u;
+
+    if (argc == 3)
+    {
+        BufferedWriter out(argv[2]);
+        write_graph(out, format, graph);
+        written = graph.vertex_count();
+    }
+    else
+    {
+        const double minutes = std::atof(argv[5]);
+        if (!(minutes >= 0.0))
+        {
+            std::cerr << "Enter a travel time of at least 0 minutes.";
+            return EXIT_FAILURE;
+        }
+
+        //costs are metres per km/h, 3.6 of them to a second
+        const Graph::cost_t limit = minutes * 60.0 / 3.6;
+        const Graph::index_t source = graph.index_of(graph.from_location({std::atof(argv[3]), std::atof(argv[4])}));
+        SearchSpace space(graph.vertex_count());
+        NullVisitor visitor;
+        search<BinaryHeap>(graph, source, space, ZeroHeuristic(), StopAtCost{limit}, visitor);
+
+        //every vertex within the limit is settled before the search stops
+        std::vector<Graph::Location> points;
+        for(Graph::index_t v = 0u; v < graph.vertex_count(); ++v)
+        {
+            if (space.cost[v] <= limit)
+                points.push_back(graph.vertex_location(v));
+        }
+
+        BufferedWriter out(argv[2]);
+        write_points(out, format, points);
+        written = points.size();
+    }
+
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+    std::cout << written << " vertices written in " << duration.count() << "s." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -1,71 +1,141 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <random>
+#include <thread>
 #include "graph.hpp"
 
-int main(int argc, char **argv)
+struct Measure
 {
-	if (argc != 6)
-	{
-		std::cerr << "5 arguments expected: file_input, lat1, lon1, lat2, lon2";
-        return EXIT_FAILURE;
-	}
+    bool found;
+    double time;
+    Graph::cost_t cost;
+};
+
+static const double DEFAULT_WEIGHTS[] = {1.0, 1.1, 1.25, 1.5, 2.0, 3.0};
 
-	Graph graph(argv[1]);
-	Graph::id_t v1 = graph.from_location({std::atof(argv[2]), std::atof(argv[3])});
-    Graph::id_t v2 = graph.from_location({std::atof(argv[4]), std::atof(argv[5])});
+static Measure measure(const Graph &graph, Graph::id_t v1, Graph::id_t v2, double weight)
+{
     std::map<Graph::id_t, Graph::id_t> came_from;
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
-    bool found = graph.dijkstra(v1, v2, came_from);
-    std::chrono::time_point<std::chrono::high_resolution_clock> stop = std::chrono::high_resolution_clock::now();
+    const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    const bool found = weight > 0.0 ? graph.astar(v1, v2, came_from, weight) : graph.dijkstra(v1, v2, came_from);
+    const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
 
-    std::chrono::duration<double> duration = stop - start;
-    double time_dijkstra = duration.count();
-    std::cout << "Dijsktra took " << time_dijkstra << "s." << std::endl << std::endl;
+    return {found, duration.count(), found ? graph.path_cost(graph.reconstruct_path(v1, v2, came_from)) : 0.0};
+}
 
-	if (!found)
+int main(int argc, char **argv)
+{
+    if (argc < 3)
     {
-        std::cerr << "The path was not found (dijkstra).";
+        std::cerr << "2+ arguments expected: file_input, number of queries, (optional : threads), (optional : weights...)";
         return EXIT_FAILURE;
     }
 
-	const std::vector<Graph::id_t> path_dijkstra = graph.reconstruct_path(v1, v2, came_from);
+    const std::size_t queries = std::strtoul(argv[2], nullptr, 10);
+    std::size_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+    std::vector<double> weights;
+    for(int i = 4; i < argc; ++i)
+        weights.push_back(std::atof(argv[i]));
+    if (weights.empty())
+        weights.assign(std::begin(DEFAULT_WEIGHTS), std::end(DEFAULT_WEIGHTS));
 
-    bool paths_equal = false;
-
-    graph.factor = 14.5;
+    if (queries == 0u)
+    {
+        std::cerr << "Enter a positive number of queries.";
+        return EXIT_FAILURE;
+    }
 
-    do
+    if (std::any_of(weights.begin(), weights.end(), [](double w) { return w < 1.0; }))
     {
-    	graph.factor -= 0.5;
+        std::cerr << "Weights must be at least 1.";
+        return EXIT_FAILURE;
+    }
 
-		start = std::chrono::high_resolution_clock::now();
-	    found = graph.astar(v1, v2, came_from);
-	    stop = std::chrono::high_resolution_clock::now();
+    const Graph graph(argv[1]);
+    const std::size_t n = graph.vertex_count();
+    threads = std::max<std::size_t>(1u, threads);
 
-	    duration = stop - start;
+    if (n == 0u)
+    {
+        std::cerr << "Empty graph.";
+        return EXIT_FAILURE;
+    }
 
-	    if (!found)
-	    {
-	        std::cerr << "The path was not found (astar).";
-	        return EXIT_FAILURE;
-	    }
+    std::cout << "Heuristic speed bound " << graph.heuristic_speed() << " km per unit of cost, " <<
+        queries << " queries on " << threads << " threads." << std::endl;
 
-	    //found
-	    std::vector<Graph::id_t> path_astar = graph.reconstruct_path(v1, v2, came_from);
+    //column 0 is the Dijkstra reference, then one column per weight
+    const std::size_t columns = weights.size() + 1;
+    std::vector<Measure> results(queries * columns);
+    std::atomic<std::size_t> next(0u);
+
+    //queries are seeded by their number, so the set does not depend on the thread count
+    auto worker = [&]()
+    {
+        for(std::size_t q = next++; q < queries; q = next++)
+        {
+            std::mt19937_64 random(q);
+            std::uniform_int_distribution<Graph::index_t> pick(0u, static_cast<Graph::index_t>(n - 1));
+            const Graph::id_t v1 = graph.vertex_id(pick(random));
+            const Graph::id_t v2 = graph.vertex_id(pick(random));
+
+            results[q * columns] = measure(graph, v1, v2, 0.0);
+            for(std::size_t w = 0u; w < weights.size(); ++w)
+                results[q * columns + w + 1] = measure(graph, v1, v2, weights[w]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(std::size_t t = 0u; t < threads; ++t)
+        pool.emplace_back(worker);
+    for(std::thread &t : pool)
+        t.join();
+
+    double dijkstra_time = 0.0;
+    std::size_t routed = 0u;
+    for(std::size_t q = 0u; q < queries; ++q)
+    {
+        if (results[q * columns].found)
+        {
+            dijkstra_time += results[q * columns].time;
+            routed++;
+        }
+    }
 
-	    paths_equal = std::equal(path_astar.begin(), path_astar.end(), 
-	    	path_dijkstra.begin(), path_dijkstra.end());
+    if (routed == 0u)
+    {
+        std::cerr << "No query found a path.";
+        return EXIT_FAILURE;
+    }
 
-	    std::cout << "Factor " << graph.factor << " took " << "s." << std::endl;
-	    
-	}
-	while(!paths_equal && graph.factor > 0.0);
+    std::cout << "Dijkstra: " << dijkstra_time / routed << "s per query, " << routed << " paths." << std::endl;
+    std::cout << "weight\ttime\tspeedup\texact\tmean excess\tmax excess" << std::endl;
 
-	if (graph.factor <= 0.0)
-		std::cout << "Negative.";
-	else
-		std::cout << "FACTOR: " << graph.factor;
+    for(std::size_t w = 0u; w < weights.size(); ++w)
+    {
+        double time = 0.0, excess = 0.0, max_excess = 0.0;
+        std::size_t exact = 0u;
+
+        for(std::size_t q = 0u; q < queries; ++q)
+        {
+            const Measure &reference = results[q * columns];
+            const Measure &m = results[q * columns + w + 1];
+            if (!reference.found || !m.found)
+                continue;
+
+            const double ratio = reference.cost > 0.0 ? m.cost / reference.cost : 1.0;
+            time += m.time;
+            excess += ratio - 1.0;
+            max_excess = std::max(max_excess, ratio - 1.0);
+            if (ratio <= 1.0 + 1e-9)
+                exact++;
+        }
+
+        std::cout << weights[w] << '\t' << time / routed << "s\t" << dijkstra_time / time << "x\t" <<
+            100.0 * exact / routed << "%\t" << 100.0 * excess / routed << "%\t" << 100.0 * max_excess << "%" << std::endl;
+    }
 
-	return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return EXIT_SUCCESS;
+}
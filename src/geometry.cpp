@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "geometry.hpp"
+
+constexpr double ShapeStore::COORDINATE_PRECISION;
+constexpr std::uint32_t ShapeStore::MAGIC;
+
+ShapeStore::ShapeStore()
+: offsets(1u, 0u), bytes(), file(),
+	offsets_ptr(offsets.data()), bytes_ptr(nullptr), n_shapes(0u)
+{}
+
+ShapeStore::ShapeStore(const char *filename)
+: offsets(1u, 0u), bytes(), file(filename),
+	offsets_ptr(offsets.data()), bytes_ptr(nullptr), n_shapes(0u)
+{
+	//layout: magic, padding, count, offsets[count + 1], bytes
+	const std::size_t header = 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+	if (!file.is_open() || file.size() < header)
+		return;
+
+	std::uint32_t magic;
+	std::uint64_t count;
+	std::memcpy(&magic, file.data(), sizeof(magic));
+	std::memcpy(&count, file.data() + 2 * sizeof(std::uint32_t), sizeof(count));
+
+	if (magic != MAGIC || file.size() < header + (count + 1) * sizeof(std::uint64_t))
+	{
+		file.close();
+		return;
+	}
+
+	offsets_ptr = reinterpret_cast<const std::uint64_t*>(file.data() + header);
+	bytes_ptr = file.data() + header + (count + 1) * sizeof(std::uint64_t);
+	n_shapes = count;
+}
+
+inline void ShapeStore::put_varint(std::vector<std::uint8_t> &out, std::int64_t value)
+{
+	//zigzag so that small negative deltas stay short
+	std::uint64_t v = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+
+	while (v >= 0x80)
+	{
+		out.push_back(static_cast<std::uint8_t>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<std::uint8_t>(v));
+}
+
+inline std::int64_t ShapeStore::get_varint(const std::uint8_t *&in)
+{
+	std::uint64_t v = 0u;
+	int shift = 0;
+
+	while (*in & 0x80)
+	{
+		v |= static_cast<std::uint64_t>(*in++ & 0x7F) << shift;
+		shift += 7;
+	}
+	v |= static_cast<std::uint64_t>(*in++) << shift;
+
+	return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+ShapeStore::shape_t ShapeStore::add(Graph::Location origin, const std::vector<Graph::Location> &points)
+{
+	if (points.empty())
+		return Graph::NO_SHAPE;
+	//a larger index would read as reversed, or as no shape at all
+	if (n_shapes >= Graph::SHAPE_REVERSED)
+		throw std::length_error("ShapeStore: more than 2^31 shapes");
+
+	//each point is a delta from the previous one, the first from the edge origin
+	std::int64_t prev_lat = std::llround(origin.lat * COORDINATE_PRECISION);
+	std::int64_t prev_lon = std::llround(origin.lon * COORDINATE_PRECISION);
+
+	put_varint(bytes, static_cast<std::int64_t>(points.size()));
+
+	for(const Graph::Location &l : points)
+	{
+		const std::int64_t lat = std::llround(l.lat * COORDINATE_PRECISION);
+		const std::int64_t lon = std::llround(l.lon * COORDINATE_PRECISION);
+		put_varint(bytes, lat - prev_lat);
+		put_varint(bytes, lon - prev_lon);
+		prev_lat = lat;
+		prev_lon = lon;
+	}
+
+	offsets.push_back(bytes.size());
+	offsets_ptr = offsets.data();
+	bytes_ptr = bytes.data();
+
+	return static_cast<shape_t>(n_shapes++);
+}
+
+std::size_t ShapeStore::shape_count() const noexcept
+{
+	return n_shapes;
+}
+
+std::size_t ShapeStore::byte_count() const noexcept
+{
+	return n_shapes == 0u ? 0u : static_cast<std::size_t>(offsets_ptr[n_shapes]);
+}
+
+void ShapeStore::decode(ShapeStore::shape_t shape, Graph::Location origin,
+	std::vector<Graph::Location> &out) const
+{
+	const std::size_t index = shape & ~Graph::SHAPE_REVERSED;
+	if (shape == Graph::NO_SHAPE || index >= n_shapes)
+		return;
+
+	const std::uint8_t *in = bytes_ptr + offsets_ptr[index];
+	const std::size_t first = out.size();
+	std::int64_t count = get_varint(in);
+	std::int64_t lat = std::llround(origin.lat * COORDINATE_PRECISION);
+	std::int64_t lon = std::llround(origin.lon * COORDINATE_PRECISION);
+
+	for(; count > 0; --count)
+	{
+		lat += get_varint(in);
+		lon += get_varint(in);
+		out.push_back({lat / COORDINATE_PRECISION, lon / COORDINATE_PRECISION});
+	}
+
+	if (shape & Graph::SHAPE_REVERSED)
+		std::reverse(out.begin() + first, out.end());
+}
+
+void ShapeStore::output_binary(const char *filename) const
+{
+	std::ofstream out(filename, std::ios::binary);
+	const std::uint32_t header[2] = {MAGIC, 0u};
+	const std::uint64_t count = n_shapes;
+
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	out.write(reinterpret_cast<const char*>(offsets_ptr), (n_shapes + 1) * sizeof(std::uint64_t));
+	out.write(reinterpret_cast<const char*>(bytes_ptr), byte_count());
+}
+
+double box_distance(Graph::Location min, Graph::Location max, Graph::Location l)
+{
+	const double dlat = std::max(0.0, std::max(min.lat - l.lat, l.lat - max.lat));
+	const double dlon = std::max(0.0, std::max(min.lon - l.lon, l.lon - max.lon));
+	return dlat + dlon;
+}
+
+std::vector<Graph::Location> simplify(const std::vector<Graph::Location> &points, double tolerance_m)
+{
+	if (points.size() < 3u || tolerance_m <= 0.0)
+		return points;
+
+	//local equirectangular projection is plenty for a perpendicular distance test
+	const double metres_per_degree = 111319.49;
+	const double lon_scale = std::cos(M_PI * points.front().lat / 180.0);
+	auto x = [&](const Graph::Location &l) { return l.lon * lon_scale * metres_per_degree; };
+	auto y = [&](const Graph::Location &l) { return l.lat * metres_per_degree; };
+
+	std::vector<bool> keep(points.size(), false);
+	keep.front() = keep.back() = true;
+
+	//explicit stack: long routes would overflow a recursive version
+	std::vector<std::pair<std::size_t, std::size_t>> ranges;
+	ranges.push_back({0u, points.size() - 1});
+
+	while (!ranges.empty())
+	{
+		const std::size_t first = ranges.back().first;
+		const std::size_t last = ranges.back().second;
+		ranges.pop_back();
+
+		const double ax = x(points[first]), ay = y(points[first]);
+		const double dx = x(points[last]) - ax, dy = y(points[last]) - ay;
+		const double length_sq = dx * dx + dy * dy;
+
+		double max_distance = 0.0;
+		std::size_t farthest = first;
+
+		for(std::size_t i = first + 1; i < last; ++i)
+		{
+			const double px = x(points[i]) - ax, py = y(points[i]) - ay;
+			double distance;
+
+			if (length_sq == 0.0)
+				distance = std::sqrt(px * px + py * py);
+			else
+			{
+				const double t = std::max(0.0, std::min(1.0, (px * dx + py * dy) / length_sq));
+				const double ex = px - t * dx, ey = py - t * dy;
+				distance = std::sqrt(ex * ex + ey * ey);
+			}
+
+			if (distance > max_distance)
+			{
+				max_distance = distance;
+				farthest = i;
+			}
+		}
+
+		if (max_distance > tolerance_m)
+		{
+			keep[farthest] = true;
+			ranges.push_back({first, farthest});
+			ranges.push_back({farthest, last});
+		}
+	}
+
+	std::vector<Graph::Location> result;
+	for(std::size_t i = 0u; i < points.size(); ++i)
+	{
+		if (keep[i])
+			result.push_back(points[i]);
+	}
+
+	return result;
+}
+
+std::string encode_polyline(const std::vector<Graph::Location> &points, int precision)
+{
+	const double factor = std::pow(10.0, precision);
+	std::string result;
+	std::int64_t prev_lat = 0, prev_lon = 0;
+
+	auto encode = [&result](std::int64_t value)
+	{
+		std::uint64_t v = value < 0 ? ~(static_cast<std::uint64_t>(value) << 1) : static_cast<std::uint64_t>(value) << 1;
+		while (v >= 0x20)
+		{
+			result.push_back(static_cast<char>((0x20 | (v & 0x1F)) + 63));
+			v >>= 5;
+		}
+		result.push_back(static_cast<char>(v + 63));
+	};
+
+	for(const Graph::Location &l : points)
+	{
+		const std::int64_t lat = std::llround(l.lat * factor);
+		const std::int64_t lon = std::llround(l.lon * factor);
+		encode(lat - prev_lat);
+		encode(lon - prev_lon);
+		prev_lat = lat;
+		prev_lon = lon;
+	}
+
+	return result;
+}
@@ -0,0 +1,85 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#include <string>
+#include <vector>
+#include "graph.hpp"
+#include "mapped_file.hpp"
+
+//intermediate way nodes of every edge, delta-encoded in one byte array
+class ShapeStore
+{
+public:
+	typedef Graph::shape_t shape_t;
+
+private:
+	//fixed point as stored by OSM: 1e-7 degrees
+	constexpr static double COORDINATE_PRECISION = 10000000.0;
+	constexpr static std::uint32_t MAGIC = 0x31504853; //"SHP1"
+
+	//built in memory while importing
+	std::vector<std::uint64_t> offsets;
+	std::vector<std::uint8_t> bytes;
+
+	//or mapped from a file written by output_binary
+	MappedFile file;
+	const std::uint64_t *offsets_ptr;
+	const std::uint8_t *bytes_ptr;
+	std::size_t n_shapes;
+
+	static void put_varint(std::vector<std::uint8_t>&, std::int64_t);
+	static std::int64_t get_varint(const std::uint8_t*&);
+
+public:
+	ShapeStore();
+	ShapeStore(const char*);
+	//throws std::length_error once the store holds Graph::SHAPE_REVERSED shapes
+	shape_t add(Graph::Location, const std::vector<Graph::Location>&);
+	std::size_t shape_count() const noexcept;
+	std::size_t byte_count() const noexcept;
+	void decode(shape_t, Graph::Location, std::vector<Graph::Location>&) const;
+	void output_binary(const char*) const;
+};
+
+//streams the interior shape points of one edge and then its destination into sink(Location)
+template<typename Sink>
+void unpack_edge(const ShapeStore &shapes, Graph::Location from, Graph::Location to, Graph::shape_t shape,
+	std::vector<Graph::Location> &scratch, Sink &sink)
+{
+	scratch.clear();
+	//a reversed shape was encoded starting from this edge's destination
+	if (shape != Graph::NO_SHAPE)
+		shapes.decode(shape, (shape & Graph::SHAPE_REVERSED) ? to : from, scratch);
+
+	for(const Graph::Location &l : scratch)
+		sink(l);
+
+	sink(to);
+}
+
+//streams the full-resolution geometry of a vertex path into sink(Location)
+template<typename Sink>
+void unpack_path(const Graph &graph, const ShapeStore &shapes,
+	const std::vector<Graph::id_t> &path, Sink sink)
+{
+	if (path.empty())
+		return;
+
+	std::vector<Graph::Location> scratch;
+	Graph::Location from = graph.location(path.front());
+	sink(from);
+
+	for(std::size_t i = 1u; i < path.size(); ++i)
+	{
+		const Graph::Location to = graph.location(path[i]);
+		unpack_edge(shapes, from, to, graph.edge_shape(path[i - 1], path[i]), scratch, sink);
+		from = to;
+	}
+}
+
+//degrees of latitude plus longitude from a point to the box between min and max, zero within
+double box_distance(Graph::Location, Graph::Location, Graph::Location);
+std::vector<Graph::Location> simplify(const std::vector<Graph::Location>&, double);
+std::string encode_polyline(const std::vector<Graph::Location>&, int = 5);
+
+#endif //GEOMETRY_HPP
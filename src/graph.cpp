@@ -1,57 +1,144 @@
+#include <algorithm>
 #include <limits>
 #include <cmath>
+#include <stdexcept>
+#include <unordered_map>
 #include "graph.hpp"
+#include "geometry.hpp"
+#include "output.hpp"
+#include "search.hpp"
 
 constexpr double Graph::EARTH_RADIUS_KM;
+constexpr std::uint32_t Graph::SPEED_MAGIC;
+constexpr Graph::shape_t Graph::NO_SHAPE;
+constexpr Graph::shape_t Graph::SHAPE_REVERSED;
+constexpr Graph::index_t Graph::NO_INDEX;
 
-inline bool Graph::greater_pqelement::operator() (
-	const Graph::PQElement &x, const Graph::PQElement &y) const 
+inline double Graph::degree_to_radian(double angle) const
 {
-	return x.first > y.first; 
+	return M_PI * angle / 180.0;
 }
 
-inline double Graph::degree_to_radian(double angle) const
+void Graph::project()
 {
-	return M_PI * angle / 180.0;
+	unit_x.resize(locations.size());
+	unit_y.resize(locations.size());
+	unit_z.resize(locations.size());
+	for(index_t v = 0u; v < locations.size(); ++v)
+	{
+		const double lat = degree_to_radian(locations[v].lat);
+		const double lon = degree_to_radian(locations[v].lon);
+		unit_x[v] = std::cos(lat) * std::cos(lon);
+		unit_y[v] = std::cos(lat) * std::sin(lon);
+		unit_z[v] = std::sin(lat);
+	}
+	unit_x.shrink_to_fit();
+	unit_y.shrink_to_fit();
+	unit_z.shrink_to_fit();
+}
+
+void Graph::calibrate()
+{
+	//straight-line distance over cost, maximised over edges: by the triangle inequality it bounds
+	//every path too, so dividing by it keeps estimates admissible and consistent
+	double chord_per_cost = 0.0;
+
+	for(index_t v = 0u; v < ids.size(); ++v)
+	{
+		for(const Edge &e : out_edges(v))
+		{
+			const double dx = unit_x[v] - unit_x[e.destination];
+			const double dy = unit_y[v] - unit_y[e.destination];
+			const double dz = unit_z[v] - unit_z[e.destination];
+			const double chord = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+			if (chord > 0.0)
+				chord_per_cost = std::max(chord_per_cost, e.cost > 0.0 ? chord / e.cost :
+					std::numeric_limits<double>::infinity());
+		}
+	}
+
+	//zero-cost moves between distinct points leave no usable bound: estimates become 0
+	speed_bound = chord_per_cost > 0.0 ? EARTH_RADIUS_KM * chord_per_cost : std::numeric_limits<double>::infinity();
+}
+
+double Graph::heuristic_speed() const noexcept
+{
+	return speed_bound;
+}
+
+Graph::cost_t Graph::estimate(Graph::index_t v1, Graph::index_t v2) const
+{
+	//chords, as calibrate() bounds the speed with, so this never exceeds the true cost
+	const double dx = unit_x[v1] - unit_x[v2], dy = unit_y[v1] - unit_y[v2], dz = unit_z[v1] - unit_z[v2];
+
+	return std::sqrt(dx * dx + dy * dy + dz * dz) * (EARTH_RADIUS_KM / speed_bound);
+}
+
+//out must not overlap the axis arrays, which lets the indexed loads become vector gathers
+static void squared_chords(const Graph::index_t *vertices, std::size_t count, const double *__restrict ux,
+	const double *__restrict uy, const double *__restrict uz, double gx, double gy, double gz, double *__restrict out)
+{
+	for(std::size_t i = 0u; i < count; ++i)
+	{
+		const Graph::index_t v = vertices[i];
+		const double dx = ux[v] - gx, dy = uy[v] - gy, dz = uz[v] - gz;
+		out[i] = dx * dx + dy * dy + dz * dz;
+	}
+}
+
+void Graph::estimate_batch(const Graph::index_t *vertices, std::size_t count, Graph::index_t goal,
+	Graph::cost_t *out) const
+{
+	//two branch-free vector loops over a whole adjacency: squared chords, then their roots in place
+	//(which needs -fno-math-errno)
+	squared_chords(vertices, count, unit_x.data(), unit_y.data(), unit_z.data(),
+		unit_x[goal], unit_y[goal], unit_z[goal], out);
+
+	const double scale = EARTH_RADIUS_KM / speed_bound;
+	for(std::size_t i = 0u; i < count; ++i)
+		out[i] = std::sqrt(out[i]) * scale;
 }
 
-inline Graph::cost_t Graph::heuristic(const Graph::Vertex &v1, const Graph::Vertex &v2) const 
+Graph::index_t Graph::index_of(Graph::id_t vertex_id) const
 {
-	const Location &l1 = v1.loc;
-	const Location &l2 = v2.loc;
-
-	const double lat_rad1 = degree_to_radian(l1.lat);
-	const double lat_rad2 = degree_to_radian(l2.lat);
-	const double lon_rad1 = degree_to_radian(l1.lon);
-	const double lon_rad2 = degree_to_radian(l2.lon);
- 
-	const double diff_lat = lat_rad2 - lat_rad1;
-	const double diff_lon = lon_rad2 - lon_rad1;
- 
-	const double computation = std::asin(std::sqrt(std::sin(diff_lat / 2) * std::sin(diff_lat / 2) + 
-		std::cos(lat_rad1) * std::cos(lat_rad2) * std::sin(diff_lon / 2) * std::sin(diff_lon / 2)));
-
-	return 2.0 * EARTH_RADIUS_KM * computation / 35.0;
+	auto it = std::lower_bound(ids.cbegin(), ids.cend(), vertex_id);
+	if (it == ids.cend() || *it != vertex_id)
+		throw std::out_of_range("Graph: unknown vertex id");
+
+	return static_cast<index_t>(it - ids.cbegin());
 }
 
 Graph::Graph()
-: vertices()
+: ids(), locations(), unit_x(), unit_y(), unit_z(), first_edge(1u, 0u), edges(),
+	speed_bound(std::numeric_limits<double>::infinity())
 {}
 
 Graph::Graph(const char *filename)
+: ids(), locations(), unit_x(), unit_y(), unit_z(), first_edge(1u, 0u), edges(),
+	speed_bound(std::numeric_limits<double>::infinity())
 {
 	std::ifstream in(filename, std::ios::binary);
 
+	std::size_t n_vertices = 0u;
 	in.read(reinterpret_cast<char*>(&n_vertices), sizeof(n_vertices));
 
-	std::multimap<id_t, Connection> connections;
+	ids.reserve(n_vertices);
+	locations.reserve(n_vertices);
+	first_edge.reserve(n_vertices + 1);
+
+	//vertex records are written in id order, so destinations resolve by binary search
+	std::vector<id_t> destinations;
 
 	for(std::size_t n = 0u; n < n_vertices; ++n)
 	{
-		Vertex vertex;
-		
-		in.read(reinterpret_cast<char*>(&vertex.id), sizeof(vertex.id));
-		in.read(reinterpret_cast<char*>(&vertex.loc), sizeof(vertex.loc));
+		id_t id;
+		Location loc;
+
+		in.read(reinterpret_cast<char*>(&id), sizeof(id));
+		in.read(reinterpret_cast<char*>(&loc), sizeof(loc));
+		ids.push_back(id);
+		locations.push_back(loc);
 
 		std::size_t n_connections = 0u;
 		in.read(reinterpret_cast<char*>(&n_connections), sizeof(n_connections));
@@ -60,70 +147,66 @@ Graph::Graph(const char *filename)
 		{
 			Connection conn;
 			in.read(reinterpret_cast<char*>(&conn), sizeof(conn));
-			connections.insert({vertex.id, conn});
+			destinations.push_back(conn.id);
+			edges.push_back({NO_INDEX, NO_SHAPE, conn.cost});
 		}
 
-		vertices.insert({vertex.id, vertex});
+		first_edge.push_back(static_cast<index_t>(edges.size()));
 	}
 
-	//now traverse connections to set pointers to vertices
-	for(auto it = connections.cbegin(); it != connections.cend(); ++it)
+	//optional trailer: one shape reference per edge, in file order
+	std::vector<shape_t> shapes(edges.size(), NO_SHAPE);
+	in.read(reinterpret_cast<char*>(shapes.data()), shapes.size() * sizeof(shape_t));
+	if (!in)
+		std::fill(shapes.begin(), shapes.end(), NO_SHAPE);
+
+	//optional trailer: the speed bound computed at import
+	std::uint32_t speed_header[2] = {0u, 0u};
+	bool calibrated = false;
+	if (in.read(reinterpret_cast<char*>(speed_header), sizeof(speed_header)) && speed_header[0] == SPEED_MAGIC)
+		calibrated = static_cast<bool>(in.read(reinterpret_cast<char*>(&speed_bound), sizeof(speed_bound)));
+
+	for(std::size_t e = 0u; e < edges.size(); ++e)
 	{
-		Edge e = {&vertices.at(it->second.id), it->second.cost};
-		vertices.at(it->first).edges.push_back(e);
-		n_edges++;
+		edges[e].destination = index_of(destinations[e]);
+		edges[e].shape = shapes[e];
 	}
-}
-
-void Graph::add_vertex(Graph::id_t vertex_id, Graph::Location location)
-{
-	Vertex v;
-	v.id = vertex_id;
-	v.loc = location;
 
-	vertices[vertex_id] = v;
-	n_vertices++;
+	project();
+	if (!calibrated)
+		calibrate();
 }
 
-void Graph::add_edge(Graph::id_t from_id, Graph::id_t to_id, 
-	Graph::cost_t cost, bool one_directional) 
+std::size_t Graph::vertex_count() const noexcept
 {
-	Edge e = {&vertices.at(to_id), cost};
-	vertices.at(from_id).edges.push_back(e);
-	n_edges++;
-
-	if (!one_directional)
-	{
-		//reverse: to_id -> from_id
-		Edge back = {&vertices.at(from_id), cost};
-		vertices.at(to_id).edges.push_back(back);
-		n_edges++;
-	}
+	return ids.size();
 }
 
-inline std::size_t Graph::vertex_count() const noexcept
+std::size_t Graph::edge_count() const noexcept
 {
-	return n_vertices;
+	return edges.size();
 }
 
-inline std::size_t Graph::edge_count() const noexcept
+std::size_t Graph::memory_usage() const noexcept
 {
-	return n_edges;
+	return ids.capacity() * sizeof(id_t) + locations.capacity() * sizeof(Location) +
+		(unit_x.capacity() + unit_y.capacity() + unit_z.capacity()) * sizeof(double) +
+		first_edge.capacity() * sizeof(index_t) + edges.capacity() * sizeof(Edge);
 }
 
 Graph::id_t Graph::from_location(Graph::Location target) const
 {
-	id_t closest_match;
+	id_t closest_match = 0;
 	double minimum_difference = std::numeric_limits<double>::max();
 
-	for(auto it = vertices.cbegin(); it != vertices.cend(); ++it)
+	for(index_t v = 0u; v < locations.size(); ++v)
 	{
-		const Location l = it->second.loc;
+		const Location l = locations[v];
 		const double diff = std::abs(target.lat - l.lat) + std::abs(target.lon - l.lon);
 
 		if (diff < minimum_difference)
 		{
-			closest_match = it->first;
+			closest_match = ids[v];
 			minimum_difference = diff;
 		}
 	}
@@ -133,139 +216,400 @@ Graph::id_t Graph::from_location(Graph::Location target) const
 
 Graph::Location Graph::location(Graph::id_t vertex_id) const
 {
-	return vertices.at(vertex_id).loc;
+	return locations[index_of(vertex_id)];
 }
 
-std::ostream& operator<<(std::ostream &out, const Graph::Location &l)
+Graph::shape_t Graph::edge_shape(Graph::id_t from_id, Graph::id_t to_id) const
 {
-	out << l.lat << ", " << l.lon;
-	return out;
+	const index_t from = index_of(from_id), to = index_of(to_id);
+
+	//parallel edges: the search always relaxes the cheapest one
+	const Edge *best = nullptr;
+
+	for(index_t e = first_edge[from]; e < first_edge[from + 1]; ++e)
+	{
+		if (edges[e].destination == to && (!best || edges[e].cost < best->cost))
+			best = &edges[e];
+	}
+
+	return best ? best->shape : NO_SHAPE;
 }
 
-std::ostream& operator<<(std::ostream &out, const Graph &data)
+std::vector<std::uint32_t> Graph::components(std::size_t &n_components) const
 {
-	for(auto it = data.vertices.cbegin(); it != data.vertices.cend(); ++it)
+	//iterative Tarjan: country graphs are far too deep for the call stack
+	const std::uint32_t UNVISITED = std::numeric_limits<std::uint32_t>::max();
+	const std::size_t n = ids.size();
+
+	std::vector<std::uint32_t> index(n, UNVISITED), low(n);
+	std::vector<std::uint32_t> component(n, UNVISITED);
+	std::vector<bool> on_stack(n, false);
+	std::vector<index_t> stack;
+	std::vector<std::pair<index_t, index_t>> frames; //vertex, next edge
+	std::uint32_t counter = 0u;
+	n_components = 0u;
+
+	for(index_t root = 0u; root < n; ++root)
 	{
-		out << it->first << ": " << it->second.loc << std::endl << "{";
-		for(const Graph::Edge &e : it->second.edges)
+		if (index[root] != UNVISITED)
+			continue;
+
+		index[root] = low[root] = counter++;
+		stack.push_back(root);
+		on_stack[root] = true;
+		frames.push_back({root, first_edge[root]});
+
+		while (!frames.empty())
 		{
-			out << "(" << e.destination->id << ", " << e.cost << "), ";
+			const index_t v = frames.back().first;
+
+			if (frames.back().second < first_edge[v + 1])
+			{
+				const index_t w = edges[frames.back().second++].destination;
+
+				if (index[w] == UNVISITED)
+				{
+					index[w] = low[w] = counter++;
+					stack.push_back(w);
+					on_stack[w] = true;
+					frames.push_back({w, first_edge[w]});
+				}
+				else if (on_stack[w])
+				{
+					low[v] = std::min(low[v], index[w]);
+				}
+				continue;
+			}
+
+			frames.pop_back();
+			if (!frames.empty())
+			{
+				const index_t parent = frames.back().first;
+				low[parent] = std::min(low[parent], low[v]);
+			}
+
+			if (low[v] == index[v])
+			{
+				index_t w;
+				do
+				{
+					w = stack.back();
+					stack.pop_back();
+					on_stack[w] = false;
+					component[w] = static_cast<std::uint32_t>(n_components);
+				}
+				while (w != v);
+				n_components++;
+			}
 		}
-		out << "}" << std::endl;
 	}
 
-	return out;
+	return component;
 }
 
-void Graph::output_binary(const char *filename)
+void Graph::compact(const std::vector<bool> &keep)
 {
-	std::ofstream out(filename, std::ios::binary);
-	out.write(reinterpret_cast<const char*>(&n_vertices), sizeof(n_vertices));
-	std::map<id_t, Connection> connections;
-
-	for(auto it = vertices.cbegin(); it != vertices.cend(); ++it)
+	//drops vertices not kept and every edge touching them; indices only move down, so in place
+	std::vector<index_t> new_index(ids.size(), NO_INDEX);
+	index_t n_kept = 0u;
+	for(index_t v = 0u; v < ids.size(); ++v)
 	{
-		const Vertex &vertex = it->second;
-		const std::size_t n_connections = vertex.edges.size();
+		if (keep[v])
+			new_index[v] = n_kept++;
+	}
 
-		out.write(reinterpret_cast<const char*>(&vertex.id), sizeof(vertex.id));
-		out.write(reinterpret_cast<const char*>(&vertex.loc), sizeof(vertex.loc));
+	index_t vw = 0u, ew = 0u;
+	for(index_t v = 0u; v < ids.size(); ++v)
+	{
+		const index_t begin = first_edge[v], end = first_edge[v + 1];
+		if (!keep[v])
+			continue;
 
-		out.write(reinterpret_cast<const char*>(&n_connections), sizeof(n_connections));
+		ids[vw] = ids[v];
+		locations[vw] = locations[v];
+		first_edge[vw] = ew;
 
-		for(const Edge &e : vertex.edges)
+		for(index_t e = begin; e < end; ++e)
 		{
-			Connection conn = {e.destination->id, e.cost};
-			out.write(reinterpret_cast<const char*>(&conn), sizeof(conn));
+			if (keep[edges[e].destination])
+			{
+				edges[ew] = edges[e];
+				edges[ew].destination = new_index[edges[e].destination];
+				ew++;
+			}
 		}
+		vw++;
 	}
+	first_edge[vw] = ew;
+
+	ids.resize(vw);
+	locations.resize(vw);
+	first_edge.resize(vw + 1);
+	edges.resize(ew);
+	ids.shrink_to_fit();
+	locations.shrink_to_fit();
+	first_edge.shrink_to_fit();
+	edges.shrink_to_fit();
+	project();
+	calibrate();
 }
 
-bool Graph::dijkstra(Graph::id_t start_id, Graph::id_t goal_id,
-	std::map<Graph::id_t, Graph::id_t> &came_from) const
+std::vector<std::size_t> Graph::component_sizes() const
 {
-	std::map<id_t, cost_t> cost_so_far;
-	PriorityQueue frontier;
+	std::size_t n_components = 0u;
+	const std::vector<std::uint32_t> component = components(n_components);
+
+	std::vector<std::size_t> sizes(n_components, 0u);
+	for(std::uint32_t c : component)
+		sizes[c]++;
+
+	std::sort(sizes.begin(), sizes.end(), std::greater<std::size_t>());
+	return sizes;
+}
+
+std::size_t Graph::keep_largest_component()
+{
+	std::size_t n_components = 0u;
+	const std::vector<std::uint32_t> component = components(n_components);
+
+	if (n_components < 2u)
+		return 0u;
 
-	frontier.push(PQElement(0.0, &vertices.at(start_id)));
-	//came_from[start_id] = start_id;
-	cost_so_far[start_id] = 0.0;
+	std::vector<std::size_t> sizes(n_components, 0u);
+	for(std::uint32_t c : component)
+		sizes[c]++;
+	const std::uint32_t largest = static_cast<std::uint32_t>(
+		std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
 
-	while (!frontier.empty()) 
+	std::vector<bool> keep(ids.size());
+	for(index_t v = 0u; v < ids.size(); ++v)
+		keep[v] = component[v] == largest;
+
+	const std::size_t removed = ids.size() - sizes[largest];
+	compact(keep);
+	return removed;
+}
+
+std::size_t Graph::contract_chains(ShapeStore *shapes)
+{
+	const std::size_t n = ids.size();
+
+	//incoming edges of each vertex as edge indices, plus the source of every edge
+	std::vector<index_t> source(edges.size());
+	std::vector<index_t> first_in(n + 1, 0u), in_edges(edges.size());
+
+	for(index_t v = 0u; v < n; ++v)
+	{
+		for(index_t e = first_edge[v]; e < first_edge[v + 1]; ++e)
+		{
+			source[e] = v;
+			first_in[edges[e].destination + 1]++;
+		}
+	}
+	for(std::size_t v = 0u; v < n; ++v)
+		first_in[v + 1] += first_in[v];
 	{
-		const Vertex *current = frontier.top().second;
-		frontier.pop();
+		std::vector<index_t> fill(first_in.begin(), first_in.end() - 1);
+		for(index_t e = 0u; e < edges.size(); ++e)
+			in_edges[fill[edges[e].destination]++] = e;
+	}
+
+	//redirecting an edge moves it into another vertex's incoming list
+	auto replace_in = [&](index_t vertex, index_t old_edge, index_t new_edge)
+	{
+		std::replace(in_edges.begin() + first_in[vertex], in_edges.begin() + first_in[vertex + 1],
+			old_edge, new_edge);
+	};
+
+	//joins the shapes of x -> v and v -> y into one for x -> y
+	std::vector<Location> points;
+	auto merge_shape = [&](index_t x, index_t v, const Edge &first, const Edge &second) -> shape_t
+	{
+		if (!shapes)
+			return NO_SHAPE;
 
-		if (current->id == goal_id) 
+		points.clear();
+		shapes->decode(first.shape, locations[(first.shape & SHAPE_REVERSED) ? v : x], points);
+		points.push_back(locations[v]);
+		shapes->decode(second.shape, locations[(second.shape & SHAPE_REVERSED) ? second.destination : v], points);
+		return shapes->add(locations[x], points);
+	};
+
+	std::vector<bool> keep(n, true);
+	std::size_t removed = 0u;
+
+	for(index_t v = 0u; v < n; ++v)
+	{
+		const index_t n_in = first_in[v + 1] - first_in[v];
+		const index_t n_out = first_edge[v + 1] - first_edge[v];
+
+		if (n_in == 1u && n_out == 1u)
 		{
-			return true;
+			//one-way chain u -> v -> w
+			const index_t uv = in_edges[first_in[v]], vw = first_edge[v];
+			const index_t u = source[uv], w = edges[vw].destination;
+			if (u == w || u == v || w == v)
+				continue;
+
+			edges[uv].shape = merge_shape(u, v, edges[uv], edges[vw]);
+			edges[uv].cost += edges[vw].cost;
+			edges[uv].destination = w;
+			replace_in(w, vw, uv);
 		}
+		else if (n_in == 2u && n_out == 2u)
+		{
+			//two-way chain u <-> v <-> w
+			const index_t vu = first_edge[v], vw = vu + 1;
+			const index_t u = edges[vu].destination, w = edges[vw].destination;
+			index_t uv = in_edges[first_in[v]], wv = in_edges[first_in[v] + 1];
+			if (source[uv] == w)
+				std::swap(uv, wv);
+			if (u == w || u == v || w == v || source[uv] != u || source[wv] != w)
+				continue;
+
+			const shape_t shape = merge_shape(u, v, edges[uv], edges[vw]);
+			edges[uv].shape = shape;
+			edges[uv].cost += edges[vw].cost;
+			edges[uv].destination = w;
+			edges[wv].shape = shape == NO_SHAPE ? NO_SHAPE : shape ^ SHAPE_REVERSED;
+			edges[wv].cost += edges[vu].cost;
+			edges[wv].destination = u;
+			replace_in(w, vw, uv);
+			replace_in(u, vu, wv);
+		}
+		else
+			continue;
+
+		keep[v] = false;
+		removed++;
+	}
+
+	compact(keep);
+	return removed;
+}
 
-		for(const Edge &edge : current->edges)
+void Graph::repack_shapes(const ShapeStore &from, ShapeStore &to)
+{
+	//both directions of an edge share one canonical shape
+	std::unordered_map<shape_t, shape_t> moved;
+	std::vector<Location> points;
+
+	for(index_t v = 0u; v < ids.size(); ++v)
+	{
+		for(index_t e = first_edge[v]; e < first_edge[v + 1]; ++e)
 		{
-			const cost_t new_cost = cost_so_far[current->id] + edge.cost;
+			Edge &edge = edges[e];
+			if (edge.shape == NO_SHAPE)
+				continue;
 
-			//if cost does not exist or new_cost is smaller, update cost
-			std::map<id_t, cost_t>::iterator it = cost_so_far.find(edge.destination->id);
-			if (it == cost_so_far.end() ||
-				new_cost < it->second) 
+			const shape_t canonical = edge.shape & ~SHAPE_REVERSED;
+			auto found = moved.find(canonical);
+
+			if (found == moved.end())
 			{
-				cost_so_far[edge.destination->id] = new_cost;
-				came_from[edge.destination->id] = current->id;
-				frontier.push(PQElement(new_cost, edge.destination));
+				const Location &origin = locations[(edge.shape & SHAPE_REVERSED) ? edge.destination : v];
+				points.clear();
+				from.decode(canonical, origin, points);
+				found = moved.insert({canonical, to.add(origin, points)}).first;
 			}
+
+			edge.shape = found->second | (edge.shape & SHAPE_REVERSED);
 		}
 	}
+}
 
-	return false;
+std::ostream& operator<<(std::ostream &out, const Graph::Location &l)
+{
+	out << l.lat << ", " << l.lon;
+	return out;
 }
 
-bool Graph::astar(Graph::id_t start_id, Graph::id_t goal_id,
-	std::map<Graph::id_t, Graph::id_t> &came_from) const
+std::ostream& operator<<(std::ostream &out, const Graph &data)
 {
-	std::map<id_t, cost_t> cost_so_far;
-	PriorityQueue frontier;
-	const Vertex &goal = vertices.at(goal_id);
+	BufferedWriter writer(out);
+	write_graph(writer, Format::Text, data);
+	return out;
+}
 
-	frontier.push(PQElement(0.0, &vertices.at(start_id)));
-	//came_from[start_id] = start_id;
-	cost_so_far[start_id] = 0.0;
+void Graph::output_binary(const char *filename) const
+{
+	std::ofstream out(filename, std::ios::binary);
+	const std::size_t n_vertices = ids.size();
+	out.write(reinterpret_cast<const char*>(&n_vertices), sizeof(n_vertices));
 
-	while (!frontier.empty()) 
+	for(index_t v = 0u; v < ids.size(); ++v)
 	{
-		const Vertex *current = frontier.top().second;
-		frontier.pop();
+		const std::size_t n_connections = first_edge[v + 1] - first_edge[v];
+
+		out.write(reinterpret_cast<const char*>(&ids[v]), sizeof(ids[v]));
+		out.write(reinterpret_cast<const char*>(&locations[v]), sizeof(locations[v]));
 
-		if (current->id == goal_id) 
+		out.write(reinterpret_cast<const char*>(&n_connections), sizeof(n_connections));
+
+		for(index_t e = first_edge[v]; e < first_edge[v + 1]; ++e)
 		{
-			return true;
+			Connection conn = {ids[edges[e].destination], edges[e].cost};
+			out.write(reinterpret_cast<const char*>(&conn), sizeof(conn));
 		}
+	}
 
-		for(const Edge &edge : current->edges)
-		{
-			const cost_t new_cost = cost_so_far[current->id] + edge.cost;
+	//trailers read back by the constructor, ignored by older readers
+	for(const Edge &e : edges)
+	{
+		out.write(reinterpret_cast<const char*>(&e.shape), sizeof(e.shape));
+	}
 
-			//if cost does not exist or new_cost is smaller, update cost
-			std::map<id_t, cost_t>::iterator it = cost_so_far.find(edge.destination->id);
-			if (it == cost_so_far.end() ||
-				new_cost < it->second) 
-			{
-				cost_so_far[edge.destination->id] = new_cost;
-				const cost_t priority = new_cost + heuristic(*edge.destination, goal);
-				came_from[edge.destination->id] = current->id;
-				frontier.push(PQElement(priority, edge.destination));
-			}
-		}
+	const std::uint32_t speed_header[2] = {SPEED_MAGIC, 0u};
+	out.write(reinterpret_cast<const char*>(speed_header), sizeof(speed_header));
+	out.write(reinterpret_cast<const char*>(&speed_bound), sizeof(speed_bound));
+}
+
+void Graph::record_path(Graph::index_t start, Graph::index_t goal,
+	const std::vector<Graph::index_t> &parent, std::map<Graph::id_t, Graph::id_t> &came_from) const
+{
+	//only the vertices on the path, which is all reconstruct_path reads
+	for(index_t v = goal; v != start; v = parent[v])
+	{
+		came_from[ids[v]] = ids[parent[v]];
 	}
+}
 
-	return false;
+bool Graph::dijkstra(Graph::id_t start_id, Graph::id_t goal_id,
+	std::map<Graph::id_t, Graph::id_t> &came_from) const
+{
+	const index_t start = index_of(start_id), goal = index_of(goal_id);
+	SearchSpace &space = thread_search_space(ids.size());
+	NullVisitor visitor;
+
+	const bool found = search<BinaryHeap>(*this, start, space, ZeroHeuristic(), StopAtTarget{goal},
+		visitor) != NO_INDEX;
+	if (found)
+		record_path(start, goal, space.parent, came_from);
+	space.reset();
+	return found;
+}
+
+bool Graph::astar(Graph::id_t start_id, Graph::id_t goal_id,
+	std::map<Graph::id_t, Graph::id_t> &came_from, double weight) const
+{
+	//weight 1 is exact; a weight w > 1 returns a path costing at most w times the optimum
+	const index_t start = index_of(start_id), goal = index_of(goal_id);
+	SearchSpace &space = thread_search_space(ids.size());
+	NullVisitor visitor;
+
+	const bool found = search<BinaryHeap>(*this, start, space, GreatCircleHeuristic(*this, goal, weight),
+		StopAtTarget{goal}, visitor) != NO_INDEX;
+	if (found)
+		record_path(start, goal, space.parent, came_from);
+	space.reset();
+	return found;
 }
 
 std::vector<Graph::id_t> Graph::reconstruct_path(Graph::id_t start_id, Graph::id_t goal_id,
 	std::map<Graph::id_t, Graph::id_t> &came_from) const
 {
 	std::vector<id_t> c;
-	
+
 	for(id_t v = goal_id; v != start_id; v = came_from[v])
 	{
 		c.push_back(v);
@@ -273,6 +617,25 @@ std::vector<Graph::id_t> Graph::reconstruct_path(Graph::id_t start_id, Graph::id
 
 	c.push_back(start_id);
 	std::reverse(c.begin(), c.end());
-	
+
 	return c;
-}
\ No newline at end of file
+}
+
+Graph::cost_t Graph::path_cost(const std::vector<Graph::id_t> &path) const
+{
+	cost_t total = 0.0;
+
+	for(std::size_t i = 1u; i < path.size(); ++i)
+	{
+		const index_t to = index_of(path[i]);
+		cost_t best = std::numeric_limits<cost_t>::infinity();
+		for(const Edge &e : out_edges(index_of(path[i - 1])))
+		{
+			if (e.destination == to)
+				best = std::min(best, e.cost);
+		}
+		total += best;
+	}
+
+	return total;
+}
@@ -1,18 +1,30 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
-#include <queue>
 #include <cstdint>
 #include <map>
-#include <list>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
+class BufferedWriter;
+class ShapeStore;
+enum class Format;
+
+//read-only road graph in compressed sparse row form; built by GraphBuilder or loaded from a file
 class Graph
 {
 public:
 	typedef double cost_t;
 	typedef std::int64_t id_t;
+	typedef std::uint32_t index_t;
+	typedef std::uint32_t shape_t;
+
+	//shape references index a ShapeStore; the top bit marks an edge traversing its shape backwards, so a store
+	//holds at most SHAPE_REVERSED (2^31) shapes
+	constexpr static shape_t NO_SHAPE = 0xFFFFFFFFu;
+	constexpr static shape_t SHAPE_REVERSED = 0x80000000u;
+	constexpr static index_t NO_INDEX = 0xFFFFFFFFu;
 
 	struct Location
 	{
@@ -20,63 +32,101 @@ public:
 		double lon;
 	};
 
-private:
-	struct Vertex
+	struct Edge
 	{
-		struct Edge
-		{
-			Vertex *destination;
-			cost_t cost;
-		};
+		index_t destination;
+		shape_t shape;
+		cost_t cost;
+	};
 
-		id_t id;
-		Location loc;
-		std::list<Edge> edges;
+	//contiguous out-edges of one vertex
+	struct EdgeRange
+	{
+		const Edge *first;
+		const Edge *last;
+
+		const Edge* begin() const { return first; }
+		const Edge* end() const { return last; }
+		std::size_t size() const { return last - first; }
 	};
 
+private:
 	struct Connection
 	{
 		id_t id;
 		cost_t cost;
 	};
 
-	typedef Vertex::Edge Edge;
-	typedef std::pair<cost_t, const Vertex*> PQElement;
-
-	struct greater_pqelement
-	{
-		bool operator() (const PQElement&, const PQElement&) const;
-	};
-
-	typedef std::priority_queue<PQElement, std::vector<PQElement>, greater_pqelement> PriorityQueue;
-
 	//constants
 	constexpr static double EARTH_RADIUS_KM = 6372.8;
+	//"SPD1", tags the speed bound trailer
+	constexpr static std::uint32_t SPEED_MAGIC = 0x31445053;
 
-	//attributes
-	std::size_t n_vertices;
-	std::size_t n_edges;
-	std::map<id_t, Vertex> vertices;
+	//attributes: vertices sorted by id, edges of vertex v in [first_edge[v], first_edge[v + 1])
+	std::vector<id_t> ids;
+	std::vector<Location> locations;
+	//locations projected onto the unit sphere, one array per axis so batches load them as vectors
+	std::vector<double> unit_x;
+	std::vector<double> unit_y;
+	std::vector<double> unit_z;
+	std::vector<index_t> first_edge;
+	std::vector<Edge> edges;
+	//largest straight-line km per unit of cost over all edges; estimates divide by it
+	double speed_bound;
 
 	//private methods
 	double degree_to_radian(double) const;
-	cost_t heuristic(const Vertex&, const Vertex&) const;
+	void project();
+	void calibrate();
+	void record_path(index_t, index_t, const std::vector<index_t>&, std::map<id_t, id_t>&) const;
+	std::vector<std::uint32_t> components(std::size_t&) const;
+	void compact(const std::vector<bool>&);
+
+	friend class GraphBuilder;
 
 public:
 	Graph();
 	Graph(const char*);
-	void add_vertex(id_t, Location);
-	void add_edge(id_t, id_t, cost_t, bool);
 	std::size_t vertex_count() const noexcept;
 	std::size_t edge_count() const noexcept;
+	std::size_t memory_usage() const noexcept;
+	index_t index_of(id_t) const;
+	id_t vertex_id(index_t) const;
+	const Location& vertex_location(index_t) const;
+	EdgeRange out_edges(index_t) const;
 	id_t from_location(Location) const;
 	Location location(id_t) const;
+	shape_t edge_shape(id_t, id_t) const;
+	double heuristic_speed() const noexcept;
+	cost_t estimate(index_t, index_t) const;
+	void estimate_batch(const index_t*, std::size_t, index_t, cost_t*) const;
+	std::vector<std::size_t> component_sizes() const;
+	std::size_t keep_largest_component();
+	std::size_t contract_chains(ShapeStore*);
+	void repack_shapes(const ShapeStore&, ShapeStore&);
 	friend std::ostream& operator<<(std::ostream&, const Location&);
 	friend std::ostream& operator<< (std::ostream&, const Graph&);
-	void output_binary(const char*);
+	friend void write_graph(BufferedWriter&, Format, const Graph&);
+	void output_binary(const char*) const;
 	bool dijkstra(id_t, id_t, std::map<id_t, id_t>&) const;
-	bool astar(id_t, id_t, std::map<id_t, id_t>&) const;
+	bool astar(id_t, id_t, std::map<id_t, id_t>&, double = 1.0) const;
 	std::vector<id_t> reconstruct_path(id_t, id_t, std::map<id_t, id_t>&) const;
+	cost_t path_cost(const std::vector<id_t>&) const;
 };
 
-#endif //GRAPH_HPP
\ No newline at end of file
+inline Graph::id_t Graph::vertex_id(Graph::index_t v) const
+{
+	return ids[v];
+}
+
+inline const Graph::Location& Graph::vertex_location(Graph::index_t v) const
+{
+	return locations[v];
+}
+
+inline Graph::EdgeRange Graph::out_edges(Graph::index_t v) const
+{
+	return {edges.data() + first_edge[v], edges.data() + first_edge[v + 1]};
+}
+
+#endif //GRAPH_HPP
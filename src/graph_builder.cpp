@@ -0,0 +1,135 @@
+#include <sys/resource.h>
+#include <algorithm>
+#include "graph_builder.hpp"
+
+GraphBuilder::GraphBuilder()
+: pending_vertices(), pending_edges()
+{}
+
+void GraphBuilder::add_vertex(Graph::id_t vertex_id, Graph::Location location)
+{
+	pending_vertices.push_back({vertex_id, location});
+}
+
+void GraphBuilder::add_edge(Graph::id_t from_id, Graph::id_t to_id,
+	Graph::cost_t cost, bool one_directional, Graph::shape_t shape)
+{
+	pending_edges.push_back({from_id, to_id, cost, shape});
+
+	if (!one_directional)
+	{
+		//reverse: to_id -> from_id, sharing the shape backwards
+		const Graph::shape_t back_shape = shape == Graph::NO_SHAPE ? Graph::NO_SHAPE : shape ^ Graph::SHAPE_REVERSED;
+		pending_edges.push_back({to_id, from_id, cost, back_shape});
+	}
+}
+
+std::size_t GraphBuilder::vertex_count() const noexcept
+{
+	return pending_vertices.size();
+}
+
+std::size_t GraphBuilder::edge_count() const noexcept
+{
+	return pending_edges.size();
+}
+
+std::size_t GraphBuilder::memory_usage() const noexcept
+{
+	return pending_vertices.memory_usage() + pending_edges.memory_usage();
+}
+
+Graph GraphBuilder::freeze()
+{
+	typedef Graph::index_t index_t;
+	Graph graph;
+
+	//vertices sorted by id, first occurrence wins
+	{
+		std::vector<PendingVertex> sorted;
+		sorted.reserve(pending_vertices.size());
+		pending_vertices.for_each([&sorted](const PendingVertex &v) { sorted.push_back(v); });
+		pending_vertices.clear();
+
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](const PendingVertex &a, const PendingVertex &b) { return a.id < b.id; });
+		sorted.erase(std::unique(sorted.begin(), sorted.end(),
+			[](const PendingVertex &a, const PendingVertex &b) { return a.id == b.id; }), sorted.end());
+
+		graph.ids.reserve(sorted.size());
+		graph.locations.reserve(sorted.size());
+		for(const PendingVertex &v : sorted)
+		{
+			graph.ids.push_back(v.id);
+			graph.locations.push_back(v.loc);
+		}
+	}
+
+	const std::size_t n = graph.ids.size();
+
+	//bucket edges by source: count, prefix sum, scatter
+	std::vector<index_t> sources;
+	sources.reserve(pending_edges.size());
+	graph.first_edge.assign(n + 1, 0u);
+
+	pending_edges.for_each([&](const PendingEdge &e)
+	{
+		const index_t from = graph.index_of(e.from);
+		sources.push_back(from);
+		graph.first_edge[from + 1]++;
+	});
+	for(std::size_t v = 0u; v < n; ++v)
+		graph.first_edge[v + 1] += graph.first_edge[v];
+
+	{
+		std::vector<index_t> fill(graph.first_edge.begin(), graph.first_edge.end() - 1);
+		std::size_t i = 0u;
+
+		graph.edges.resize(pending_edges.size());
+		pending_edges.for_each([&](const PendingEdge &e)
+		{
+			graph.edges[fill[sources[i++]]++] = {graph.index_of(e.to), e.shape, e.cost};
+		});
+		pending_edges.clear();
+		sources = std::vector<index_t>();
+	}
+
+	//parallel edges: keep only the cheapest, compacting in place
+	index_t ew = 0u;
+	for(index_t v = 0u; v < n; ++v)
+	{
+		const index_t begin = graph.first_edge[v], end = graph.first_edge[v + 1];
+		std::sort(graph.edges.begin() + begin, graph.edges.begin() + end,
+			[](const Graph::Edge &a, const Graph::Edge &b)
+			{
+				return a.destination < b.destination || (a.destination == b.destination && a.cost < b.cost);
+			});
+
+		graph.first_edge[v] = ew;
+		for(index_t e = begin; e < end; ++e)
+		{
+			if (e == begin || graph.edges[e].destination != graph.edges[e - 1].destination)
+				graph.edges[ew++] = graph.edges[e];
+		}
+	}
+	graph.first_edge[n] = ew;
+	graph.edges.resize(ew);
+	graph.edges.shrink_to_fit();
+	graph.project();
+	graph.calibrate();
+
+	return graph;
+}
+
+std::size_t peak_resident_memory()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0u;
+
+#ifdef __APPLE__
+	return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+	return static_cast<std::size_t>(usage.ru_maxrss) * 1024u;
+#endif
+}
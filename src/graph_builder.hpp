@@ -0,0 +1,41 @@
+#ifndef GRAPH_BUILDER_HPP
+#define GRAPH_BUILDER_HPP
+
+#include "arena.hpp"
+#include "graph.hpp"
+
+//accumulates vertices and edges in bulk, then freezes them into a Graph in one pass
+class GraphBuilder
+{
+private:
+	struct PendingVertex
+	{
+		Graph::id_t id;
+		Graph::Location loc;
+	};
+
+	struct PendingEdge
+	{
+		Graph::id_t from;
+		Graph::id_t to;
+		Graph::cost_t cost;
+		Graph::shape_t shape;
+	};
+
+	Arena<PendingVertex> pending_vertices;
+	Arena<PendingEdge> pending_edges;
+
+public:
+	GraphBuilder();
+	void add_vertex(Graph::id_t, Graph::Location);
+	void add_edge(Graph::id_t, Graph::id_t, Graph::cost_t, bool, Graph::shape_t = Graph::NO_SHAPE);
+	std::size_t vertex_count() const noexcept;
+	std::size_t edge_count() const noexcept;
+	std::size_t memory_usage() const noexcept;
+	Graph freeze();
+};
+
+//high-water mark of the process resident set, in bytes
+std::size_t peak_resident_memory();
+
+#endif //GRAPH_BUILDER_HPP
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include "geometry.hpp"
+#include "graph_registry.hpp"
+
+constexpr std::size_t GraphRegistry::NO_REGION;
+
+static bool is_ready(const std::shared_future<GraphRegistry::GraphPtr> &graph)
+{
+	return graph.valid() && graph.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+//a missing or unreadable file loads as an empty graph
+static GraphRegistry::GraphPtr read_graph(const std::string &file)
+{
+	GraphRegistry::GraphPtr graph = std::make_shared<const Graph>(file.c_str());
+	if (graph->vertex_count() == 0u)
+		throw std::runtime_error("Could not load graph " + file);
+	return graph;
+}
+
+GraphRegistry::Region describe_region(const Graph &graph, const std::string &file)
+{
+	GraphRegistry::Region region = {file,
+		{std::numeric_limits<double>::max(), std::numeric_limits<double>::max()},
+		{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()}};
+
+	for(Graph::index_t v = 0u; v < graph.vertex_count(); ++v)
+	{
+		const Graph::Location &l = graph.vertex_location(v);
+		region.min = {std::min(region.min.lat, l.lat), std::min(region.min.lon, l.lon)};
+		region.max = {std::max(region.max.lat, l.lat), std::max(region.max.lon, l.lon)};
+	}
+
+	return region;
+}
+
+GraphRegistry::GraphRegistry(const std::string &input, std::size_t max_graphs, std::size_t threads)
+: max_loaded(max_graphs), mutex(), entries(), clock(0u),
+	queue_mutex(), queue_changed(), tasks(), stopping(false), loaders()
+{
+	//graphs without recorded extents are loaded now to measure them, and kept
+	auto measured = [this](const std::string &file)
+	{
+		const GraphPtr graph = read_graph(file);
+		std::promise<GraphPtr> loaded;
+		loaded.set_value(graph);
+		entries.push_back({describe_region(*graph, file), loaded.get_future().share(), 0u});
+	};
+
+	const bool is_graph = input.size() > 4 && input.compare(input.size() - 4, 4, ".dat") == 0;
+	if (is_graph)
+	{
+		measured(input);
+	}
+	else
+	{
+		std::ifstream in(input);
+		if (!in)
+			throw std::runtime_error("Could not open region manifest " + input);
+
+		//relative entries are relative to the manifest, wherever it is read from
+		const std::filesystem::path directory = std::filesystem::path(input).parent_path();
+		std::string line;
+
+		while (std::getline(in, line))
+		{
+			std::istringstream words(line);
+			std::string file;
+			if (!(words >> file) || file[0] == '#')
+				continue;
+			file = (directory / file).string();
+
+			Region region = {file, {0.0, 0.0}, {0.0, 0.0}};
+			if (words >> region.min.lat >> region.min.lon >> region.max.lat >> region.max.lon)
+				entries.push_back({region, std::shared_future<GraphPtr>(), 0u});
+			else
+				measured(file);
+		}
+	}
+
+	threads = std::max<std::size_t>(1u, threads);
+	for(std::size_t t = 0u; t < threads; ++t)
+		loaders.emplace_back(&GraphRegistry::work, this);
+}
+
+GraphRegistry::~GraphRegistry()
+{
+	//queued preloads are dropped: nobody waits on a load before it is claimed
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		stopping = true;
+	}
+	queue_changed.notify_all();
+
+	for(std::thread &t : loaders)
+		t.join();
+}
+
+void GraphRegistry::work()
+{
+	for(;;)
+	{
+		std::size_t r;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_changed.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping)
+				return;
+			r = tasks.front();
+			tasks.pop_front();
+		}
+
+		std::shared_future<GraphPtr> result;
+		const std::shared_ptr<std::promise<GraphPtr>> promise = claim(r, result);
+		if (promise)
+			load(r, *promise);
+	}
+}
+
+std::shared_ptr<std::promise<GraphRegistry::GraphPtr>> GraphRegistry::claim(std::size_t r,
+	std::shared_future<GraphPtr> &result)
+{
+	//the graph loaded or being loaded; otherwise a promise of it, which the caller must fulfil
+	std::lock_guard<std::mutex> lock(mutex);
+	Entry &entry = entries[r];
+	entry.last_used = ++clock;
+
+	if (entry.graph.valid())
+	{
+		result = entry.graph;
+		return nullptr;
+	}
+
+	std::shared_ptr<std::promise<GraphPtr>> promise = std::make_shared<std::promise<GraphPtr>>();
+	entry.graph = promise->get_future().share();
+	result = entry.graph;
+	return promise;
+}
+
+void GraphRegistry::load(std::size_t r, std::promise<GraphPtr> &promise)
+{
+	//read outside the lock; a failure is kept, and served to every caller, until the region is unloaded
+	try
+	{
+		promise.set_value(read_graph(entries[r].region.file));
+	}
+	catch (...)
+	{
+		promise.set_exception(std::current_exception());
+		return;
+	}
+
+	evict(r);
+}
+
+void GraphRegistry::evict(std::size_t keep)
+{
+	if (max_loaded == 0u)
+		return;
+
+	//least recently used first, never the graph just loaded; freed once the lock is released
+	std::vector<std::shared_future<GraphPtr>> released;
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::pair<std::uint64_t, std::size_t>> loaded;
+	for(std::size_t r = 0u; r < entries.size(); ++r)
+	{
+		if (r != keep && is_ready(entries[r].graph))
+			loaded.push_back({entries[r].last_used, r});
+	}
+	std::sort(loaded.begin(), loaded.end());
+
+	for(std::size_t i = 0u; i + max_loaded <= loaded.size(); ++i)
+		released.push_back(std::move(entries[loaded[i].second].graph));
+}
+
+std::size_t GraphRegistry::region_count() const noexcept
+{
+	return entries.size();
+}
+
+const GraphRegistry::Region& GraphRegistry::region(std::size_t r) const
+{
+	return entries[r].region;
+}
+
+std::size_t GraphRegistry::locate(Graph::Location from, Graph::Location to) const
+{
+	std::size_t best = NO_REGION;
+	double best_distance = std::numeric_limits<double>::max(), best_area = std::numeric_limits<double>::max();
+
+	for(std::size_t r = 0u; r < entries.size(); ++r)
+	{
+		const Region &region = entries[r].region;
+		const double distance = box_distance(region.min, region.max, from) +
+			box_distance(region.min, region.max, to);
+		const double area = (region.max.lat - region.min.lat) * (region.max.lon - region.min.lon);
+
+		if (distance < best_distance || (distance == best_distance && area < best_area))
+		{
+			best = r;
+			best_distance = distance;
+			best_area = area;
+		}
+	}
+
+	return best;
+}
+
+GraphRegistry::GraphPtr GraphRegistry::acquire(std::size_t r)
+{
+	std::shared_future<GraphPtr> result;
+	const std::shared_ptr<std::promise<GraphPtr>> promise = claim(r, result);
+	if (promise)
+		load(r, *promise);
+	return result.get();
+}
+
+void GraphRegistry::preload(std::size_t r)
+{
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		tasks.push_back(r);
+	}
+	queue_changed.notify_one();
+}
+
+void GraphRegistry::unload(std::size_t r)
+{
+	//freed once the lock is released
+	std::shared_future<GraphPtr> released;
+	std::lock_guard<std::mutex> lock(mutex);
+	released = std::move(entries[r].graph);
+}
+
+std::vector<GraphRegistry::GraphPtr> GraphRegistry::loaded_graphs()
+{
+	std::vector<std::shared_future<GraphPtr>> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(const Entry &e : entries)
+		{
+			if (is_ready(e.graph))
+				ready.push_back(e.graph);
+		}
+	}
+
+	//failed loads are ready too, but hold no graph
+	std::vector<GraphPtr> graphs;
+	for(const std::shared_future<GraphPtr> &graph : ready)
+	{
+		try
+		{
+			graphs.push_back(graph.get());
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
+	return graphs;
+}
+
+std::size_t GraphRegistry::loaded_count()
+{
+	return loaded_graphs().size();
+}
+
+std::size_t GraphRegistry::memory_usage()
+{
+	std::size_t total = 0u;
+	for(const GraphPtr &graph : loaded_graphs())
+		total += graph->memory_usage();
+	return total;
+}
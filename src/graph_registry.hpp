@@ -0,0 +1,81 @@
+#ifndef GRAPH_REGISTRY_HPP
+#define GRAPH_REGISTRY_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "graph.hpp"
+
+//graphs of several regions, each loaded the first time a query falls in it and then shared read-only by
+//every thread that asks; loading one region never holds up queries on the others
+class GraphRegistry
+{
+public:
+	typedef std::shared_ptr<const Graph> GraphPtr;
+
+	constexpr static std::size_t NO_REGION = static_cast<std::size_t>(-1);
+
+	struct Region
+	{
+		std::string file;
+		Graph::Location min;
+		Graph::Location max;
+	};
+
+private:
+	struct Entry
+	{
+		Region region;
+		std::shared_future<GraphPtr> graph; //invalid while unloaded
+		std::uint64_t last_used;
+	};
+
+	std::size_t max_loaded; //0 for no limit
+
+	std::mutex mutex;
+	std::vector<Entry> entries; //fixed after construction, only the graphs change
+	std::uint64_t clock;
+
+	std::mutex queue_mutex;
+	std::condition_variable queue_changed;
+	std::deque<std::size_t> tasks;
+	bool stopping;
+	std::vector<std::thread> loaders;
+
+	std::shared_ptr<std::promise<GraphPtr>> claim(std::size_t, std::shared_future<GraphPtr>&);
+	void load(std::size_t, std::promise<GraphPtr>&);
+	void evict(std::size_t);
+	void work();
+	std::vector<GraphPtr> loaded_graphs();
+
+public:
+	//a manifest with one "file [min_lat min_lon max_lat max_lon]" line per region, each file relative to the
+	//manifest's directory, or a single .dat graph; then how many graphs stay loaded (0 for all of them) and the
+	//number of background loading threads
+	GraphRegistry(const std::string&, std::size_t = 0u, std::size_t = 1u);
+	GraphRegistry(const GraphRegistry&) = delete;
+	GraphRegistry& operator=(const GraphRegistry&) = delete;
+	~GraphRegistry();
+
+	std::size_t region_count() const noexcept;
+	const Region& region(std::size_t) const;
+	//the region whose extents hold both ends, the smallest if several do, else the nearest
+	std::size_t locate(Graph::Location, Graph::Location) const;
+	//loads on the calling thread unless already loaded or loading; throws if the file cannot be read
+	GraphPtr acquire(std::size_t);
+	//queues a load on a background thread
+	void preload(std::size_t);
+	//graphs still held by a query stay alive until it lets go
+	void unload(std::size_t);
+	std::size_t loaded_count();
+	std::size_t memory_usage();
+};
+
+//extents of a graph's vertices, as a manifest line records them
+GraphRegistry::Region describe_region(const Graph&, const std::string&);
+
+#endif //GRAPH_REGISTRY_HPP
@@ -0,0 +1,56 @@
+#ifndef HIGHWAY_HPP
+#define HIGHWAY_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <osmium/osm/tag.hpp>
+
+//ways the graph is built from: every highway but footpaths
+inline bool is_routable(const osmium::TagList &tags)
+{
+    return tags.has_key("highway") &&
+        !tags.has_tag("highway", "path") &&
+        !tags.has_tag("highway", "pedestrian");
+}
+
+//maxspeed in km/h, or the default of the highway class when the tag is missing (majority)
+inline double way_speed(const osmium::TagList &tags)
+{
+    static const struct { const char *highway; double speed; } DEFAULT_SPEEDS[] =
+    {
+        {"motorway", 120.0}, {"motorway_link", 120.0},
+        {"trunk", 100.0}, {"trunk_link", 100.0},
+        {"primary", 90.0}, {"primary_link", 90.0},
+        {"secondary", 70.0}, {"secondary_link", 70.0},
+        {"tertiary", 60.0}, {"tertiary_link", 60.0},
+        {"unclassified", 50.0},
+        {"residential", 30.0},
+        {"living_street", 10.0},
+        {"service", 30.0},
+        {"track", 30.0},
+    };
+
+    const char *speed_str = tags.get_value_by_key("maxspeed");
+
+    if (!speed_str)
+    {
+        for(const auto &d : DEFAULT_SPEEDS)
+        {
+            if (tags.has_tag("highway", d.highway))
+                return d.speed;
+        }
+        return 30.0;
+    }
+
+    if (std::strstr(speed_str, "mph"))
+        return std::atof(speed_str) * 1.60934;
+    if (std::strstr(speed_str, "knots"))
+        return std::atof(speed_str) * 1.852;
+    if (std::strncmp(speed_str, "none", std::strlen(speed_str)) == 0)
+        return 180.0;
+    if (std::strncmp(speed_str, "walk", std::strlen(speed_str)) == 0)
+        return 5.0;
+    return std::atof(speed_str);
+}
+
+#endif //HIGHWAY_HPP
@@ -0,0 +1,251 @@
+#include <cstring>
+#include <fstream>
+#include "cells.hpp"
+#include "hub_labels.hpp"
+
+constexpr std::uint32_t HubLabels::NO_HUB;
+
+//"HUB1"
+static const std::uint32_t HUB_MAGIC = 0x31425548;
+
+struct HubHeader
+{
+	std::uint32_t magic;
+	std::uint32_t reserved;
+	std::uint64_t n_vertices;
+	std::uint64_t n_edges; //of the graph, to recognise labels of another one
+	std::uint64_t n_out;
+	std::uint64_t n_in;
+};
+
+struct LabelEntry
+{
+	std::uint32_t hub;
+	float cost;
+};
+
+typedef std::vector<std::vector<LabelEntry>> LabelSet;
+
+//search from the hub of the given rank, labelling each vertex it settles with that hub, except where the
+//labels so far already give the distance: such a vertex is not expanded either. hub_costs holds the hub's
+//own label of the other direction, indexed by rank.
+template<typename View>
+static void pruned_search(const View &view, Graph::index_t hub, std::uint32_t rank,
+	const std::vector<Graph::cost_t> &hub_costs, LabelSet &labels, std::vector<Graph::cost_t> &cost,
+	std::vector<Graph::index_t> &touched)
+{
+	constexpr Graph::cost_t INFINITE_COST = std::numeric_limits<Graph::cost_t>::infinity();
+	QuaternaryHeap frontier;
+
+	cost[hub] = 0.0;
+	touched.push_back(hub);
+	frontier.push(0.0, hub);
+
+	while (!frontier.empty())
+	{
+		const Graph::cost_t g = frontier.top().first;
+		const Graph::index_t current = frontier.top().second;
+		frontier.pop();
+		if (g > cost[current])
+			continue;
+
+		bool covered = false;
+		for(const LabelEntry &entry : labels[current])
+		{
+			if (hub_costs[entry.hub] + entry.cost <= g)
+			{
+				covered = true;
+				break;
+			}
+		}
+		if (covered)
+			continue;
+		labels[current].push_back({rank, static_cast<float>(g)});
+
+		for(const Graph::Edge &edge : view.out_edges(current))
+		{
+			const Graph::cost_t new_cost = g + edge.cost;
+			if (new_cost < cost[edge.destination])
+			{
+				if (cost[edge.destination] == INFINITE_COST)
+					touched.push_back(edge.destination);
+				cost[edge.destination] = new_cost;
+				frontier.push(new_cost, edge.destination);
+			}
+		}
+	}
+
+	for(Graph::index_t v : touched)
+		cost[v] = INFINITE_COST;
+	touched.clear();
+}
+
+//concatenates the labels, each closed by NO_HUB, releasing them as it goes
+static void flatten(LabelSet &labels, std::vector<std::uint64_t> &first, std::vector<std::uint32_t> &hubs,
+	std::vector<float> &costs)
+{
+	first.assign(1u, 0u);
+	for(std::vector<LabelEntry> &label : labels)
+	{
+		for(const LabelEntry &entry : label)
+		{
+			hubs.push_back(entry.hub);
+			costs.push_back(entry.cost);
+		}
+		hubs.push_back(HubLabels::NO_HUB);
+		costs.push_back(0.0f);
+		first.push_back(hubs.size());
+		std::vector<LabelEntry>().swap(label);
+	}
+}
+
+LabelStatistics write_hub_labels(const Graph &graph, const std::string &filename)
+{
+	typedef Graph::index_t index_t;
+	const std::size_t n = graph.vertex_count();
+	const Graph::cost_t INFINITE_COST = std::numeric_limits<Graph::cost_t>::infinity();
+
+	//hubs high in the dissection sit on many shortest paths, so they prune the later searches hardest
+	const std::vector<index_t> order = dissection_order(graph);
+	const ReverseView reverse(graph);
+
+	LabelSet out_labels(n), in_labels(n);
+	std::vector<Graph::cost_t> hub_costs(n, INFINITE_COST), cost(n, INFINITE_COST);
+	std::vector<index_t> touched;
+
+	for(std::uint32_t rank = 0u; rank < n; ++rank)
+	{
+		const index_t hub = order[rank];
+
+		//forwards, hub to v: in-labels, pruned through the hub's out-label
+		for(const LabelEntry &entry : out_labels[hub])
+			hub_costs[entry.hub] = entry.cost;
+		pruned_search(graph, hub, rank, hub_costs, in_labels, cost, touched);
+		for(const LabelEntry &entry : out_labels[hub])
+			hub_costs[entry.hub] = INFINITE_COST;
+
+		//backwards, v to hub: out-labels, pruned through the hub's in-label
+		for(const LabelEntry &entry : in_labels[hub])
+			hub_costs[entry.hub] = entry.cost;
+		pruned_search(reverse, hub, rank, hub_costs, out_labels, cost, touched);
+		for(const LabelEntry &entry : in_labels[hub])
+			hub_costs[entry.hub] = INFINITE_COST;
+	}
+
+	LabelStatistics stats = {n, 0u, 0u, 0u, 0u, 0u};
+	for(index_t v = 0u; v < n; ++v)
+	{
+		stats.out_entries += out_labels[v].size();
+		stats.in_entries += in_labels[v].size();
+		stats.largest_out = std::max(stats.largest_out, out_labels[v].size());
+		stats.largest_in = std::max(stats.largest_in, in_labels[v].size());
+	}
+
+	std::ofstream out(filename, std::ios::binary);
+	std::vector<std::uint64_t> first;
+	std::vector<std::uint32_t> hubs;
+	std::vector<float> costs;
+
+	flatten(out_labels, first, hubs, costs);
+	const HubHeader header = {HUB_MAGIC, 0u, n, graph.edge_count(), hubs.size(), stats.in_entries + n};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	write_array(out, first);
+	write_array(out, hubs);
+	write_array(out, costs);
+
+	hubs.clear();
+	costs.clear();
+	flatten(in_labels, first, hubs, costs);
+	write_array(out, first);
+	write_array(out, hubs);
+	write_array(out, costs);
+
+	stats.bytes = static_cast<std::size_t>(out.tellp());
+	return stats;
+}
+
+HubLabels::HubLabels(const char *filename)
+: file(filename), n_vertices(0u), n_edges(0u), first_out(nullptr), out_hubs(nullptr), out_costs(nullptr),
+	first_in(nullptr), in_hubs(nullptr), in_costs(nullptr)
+{
+	HubHeader header;
+	if (!file.is_open() || file.size() < sizeof(header))
+		return;
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	const std::size_t expected = sizeof(header) + 2 * padded((header.n_vertices + 1) * sizeof(std::uint64_t)) +
+		padded(header.n_out * sizeof(std::uint32_t)) + padded(header.n_out * sizeof(float)) +
+		padded(header.n_in * sizeof(std::uint32_t)) + padded(header.n_in * sizeof(float));
+
+	if (header.magic != HUB_MAGIC || file.size() < expected)
+	{
+		file.close();
+		return;
+	}
+
+	const std::uint8_t *p = file.data() + sizeof(header);
+	n_vertices = header.n_vertices;
+	n_edges = header.n_edges;
+	first_out = read_array<std::uint64_t>(p, n_vertices + 1);
+	out_hubs = read_array<std::uint32_t>(p, header.n_out);
+	out_costs = read_array<float>(p, header.n_out);
+	first_in = read_array<std::uint64_t>(p, n_vertices + 1);
+	in_hubs = read_array<std::uint32_t>(p, header.n_in);
+	in_costs = read_array<float>(p, header.n_in);
+}
+
+bool HubLabels::is_open() const noexcept
+{
+	return file.is_open();
+}
+
+bool HubLabels::matches(const Graph &graph) const noexcept
+{
+	return is_open() && n_vertices == graph.vertex_count() && n_edges == graph.edge_count();
+}
+
+std::size_t HubLabels::vertex_count() const noexcept
+{
+	return n_vertices;
+}
+
+std::size_t HubLabels::mapped_bytes() const noexcept
+{
+	return file.size();
+}
+
+LabelStatistics HubLabels::statistics() const
+{
+	//label sizes without their NO_HUB
+	LabelStatistics stats = {n_vertices, 0u, 0u, 0u, 0u, file.size()};
+	for(std::size_t v = 0u; v < n_vertices; ++v)
+	{
+		const std::size_t out_size = first_out[v + 1] - first_out[v] - 1;
+		const std::size_t in_size = first_in[v + 1] - first_in[v] - 1;
+		stats.out_entries += out_size;
+		stats.in_entries += in_size;
+		stats.largest_out = std::max(stats.largest_out, out_size);
+		stats.largest_in = std::max(stats.largest_in, in_size);
+	}
+	return stats;
+}
+
+DistanceOracle::DistanceOracle(const Graph &g, const HubLabels &l, double km)
+: graph(g), labels(l), local_km(km), use_labels(l.matches(g))
+{}
+
+Graph::cost_t DistanceOracle::distance(Graph::index_t s, Graph::index_t t, bool &local) const
+{
+	//the estimate times the speed bound is the chord in km
+	local = !use_labels || graph.estimate(s, t) * graph.heuristic_speed() < local_km;
+	if (!local)
+		return labels.distance(s, t);
+
+	SearchSpace &space = thread_search_space(graph.vertex_count());
+	NullVisitor visitor;
+	search<BinaryHeap>(graph, s, space, GreatCircleHeuristic(graph, t), StopAtTarget{t}, visitor);
+	const Graph::cost_t cost = space.cost[t];
+	space.reset();
+
+	return cost;
+}
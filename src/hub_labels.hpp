@@ -0,0 +1,96 @@
+#ifndef HUB_LABELS_HPP
+#define HUB_LABELS_HPP
+
+#include <string>
+#include "graph.hpp"
+#include "mapped_file.hpp"
+#include "search.hpp"
+
+struct LabelStatistics
+{
+	std::size_t vertices;
+	std::size_t out_entries;
+	std::size_t in_entries;
+	std::size_t largest_out;
+	std::size_t largest_in;
+	std::size_t bytes;
+};
+
+//2-hop labelling by pruned searches from every vertex in dissection order, written to one file
+LabelStatistics write_hub_labels(const Graph&, const std::string&);
+
+//each vertex keeps its distances to (out) and from (in) a few hubs, sorted by hub rank and closed by NO_HUB;
+//some hub on every shortest path is in both labels, so a distance is one merge of two short arrays
+class HubLabels
+{
+public:
+	constexpr static std::uint32_t NO_HUB = 0xFFFFFFFFu;
+
+private:
+	MappedFile file;
+	std::size_t n_vertices;
+	std::size_t n_edges;
+	const std::uint64_t *first_out;
+	const std::uint32_t *out_hubs;
+	const float *out_costs;
+	const std::uint64_t *first_in;
+	const std::uint32_t *in_hubs;
+	const float *in_costs;
+
+public:
+	HubLabels(const char*);
+	bool is_open() const noexcept;
+	//true when built from this graph
+	bool matches(const Graph&) const noexcept;
+	std::size_t vertex_count() const noexcept;
+	std::size_t mapped_bytes() const noexcept;
+	LabelStatistics statistics() const;
+	Graph::cost_t distance(Graph::index_t, Graph::index_t) const;
+};
+
+inline Graph::cost_t HubLabels::distance(Graph::index_t s, Graph::index_t t) const
+{
+	//both labels end in NO_HUB, which stops the merge without bounds checks
+	std::size_t i = first_out[s], j = first_in[t];
+	Graph::cost_t best = std::numeric_limits<Graph::cost_t>::infinity();
+
+	for(;;)
+	{
+		const std::uint32_t a = out_hubs[i], b = in_hubs[j];
+		if (a < b)
+			++i;
+		else if (b < a)
+			++j;
+		else
+		{
+			if (a == NO_HUB)
+				break;
+			const Graph::cost_t through = static_cast<Graph::cost_t>(out_costs[i]) + in_costs[j];
+			if (through < best)
+				best = through;
+			++i;
+			++j;
+		}
+	}
+
+	return best;
+}
+
+//labels for long queries; short ones, or a graph the labels were not built from, are searched directly,
+//since their search space is small anyway. searches use the calling thread's space, so one oracle serves
+//any number of threads
+class DistanceOracle
+{
+private:
+	const Graph &graph;
+	const HubLabels &labels;
+	double local_km;
+	bool use_labels;
+
+public:
+	DistanceOracle(const Graph&, const HubLabels&, double = 10.0);
+	//answers from the labels or by A*; 'local' tells which
+	Graph::cost_t distance(Graph::index_t, Graph::index_t, bool&) const;
+};
+
+#endif //HUB_LABELS_HPP
@@ -0,0 +1,98 @@
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//bounded least-recently-used map split into independently locked shards, so lookups on different keys rarely contend
+template<typename Value>
+class ShardedLru
+{
+private:
+	struct Shard
+	{
+		std::mutex mutex;
+		std::list<std::pair<std::uint64_t, Value>> order; //most recent first
+		std::unordered_map<std::uint64_t, typename std::list<std::pair<std::uint64_t, Value>>::iterator> index;
+	};
+
+	std::vector<Shard> shards;
+	std::size_t shard_capacity;
+
+	Shard& shard_of(std::uint64_t key)
+	{
+		//mix the bits so keys packed from coordinates or vertex pairs spread over the shards
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdull;
+		key ^= key >> 33;
+		return shards[key % shards.size()];
+	}
+
+public:
+	ShardedLru(std::size_t capacity, std::size_t n_shards)
+	: shards(n_shards > 0u ? n_shards : 1u), shard_capacity(capacity / shards.size() > 0u ? capacity / shards.size() : 1u)
+	{}
+
+	bool get(std::uint64_t key, Value &value)
+	{
+		Shard &s = shard_of(key);
+		std::lock_guard<std::mutex> lock(s.mutex);
+
+		auto it = s.index.find(key);
+		if (it == s.index.end())
+			return false;
+
+		s.order.splice(s.order.begin(), s.order, it->second);
+		value = it->second->second;
+		return true;
+	}
+
+	void put(std::uint64_t key, const Value &value)
+	{
+		Shard &s = shard_of(key);
+		std::lock_guard<std::mutex> lock(s.mutex);
+
+		auto it = s.index.find(key);
+		if (it != s.index.end())
+		{
+			it->second->second = value;
+			s.order.splice(s.order.begin(), s.order, it->second);
+			return;
+		}
+
+		s.order.emplace_front(key, value);
+		s.index[key] = s.order.begin();
+		if (s.order.size() > shard_capacity)
+		{
+			s.index.erase(s.order.back().first);
+			s.order.pop_back();
+		}
+	}
+
+	void clear()
+	{
+		for(Shard &s : shards)
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			s.order.clear();
+			s.index.clear();
+		}
+	}
+
+	std::size_t size()
+	{
+		std::size_t total = 0u;
+		for(Shard &s : shards)
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			total += s.order.size();
+		}
+		return total;
+	}
+};
+
+#endif //LRU_CACHE_HPP
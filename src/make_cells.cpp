@@ -0,0 +1,52 @@
+#include <sys/stat.h>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include "graph.hpp"
+#include "cells.hpp"
+
+int main(int argc, char **argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cerr << "2/3 arguments expected: file_input, directory_output, (optional : max vertices per cell)";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t max_cell_vertices = argc == 4 ? std::strtoul(argv[3], nullptr, 10) : 100000u;
+    const std::string directory(argv[2]);
+
+    if (max_cell_vertices == 0u)
+    {
+        std::cerr << "Enter a positive number of vertices per cell.";
+        return EXIT_FAILURE;
+    }
+
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        std::cerr << "Could not create directory " << directory << ".";
+        return EXIT_FAILURE;
+    }
+
+    Graph graph(argv[1]);
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    std::size_t n_cells = 0u;
+    const std::vector<std::uint32_t> cell = partition_graph(graph, max_cell_vertices, n_cells);
+    const CellStatistics stats = write_cells(graph, cell, n_cells, directory);
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+    //shape references stay valid, so the geometry is shared as is
+    std::ifstream shapes_in(std::string(argv[1]) + ".geom", std::ios::binary);
+    if (shapes_in)
+    {
+        std::ofstream shapes_out(directory + "/shapes.geom", std::ios::binary);
+        shapes_out << shapes_in.rdbuf();
+    }
+
+    std::cout << stats.cells << " cells (largest " << stats.largest_cell << " vertices), " <<
+        stats.cut_edges << " cut edges, " << stats.boundary_vertices << " boundary vertices, " <<
+        stats.overlay_edges << " overlay edges, in " << duration.count() << "s." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -6,9 +6,14 @@
 #include <osmium/handler/node_locations_for_ways.hpp>
 #include <osmium/index/map/all.hpp>
 
+#include <chrono>
 #include <cstring>
+#include <string>
 
 #include "graph.hpp"
+#include "graph_builder.hpp"
+#include "geometry.hpp"
+#include "highway.hpp"
 
 typedef osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location> index_neg_type;
 typedef osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
@@ -26,7 +31,10 @@ private:
     index_pos_type index_pos;
     index_neg_type index_neg;
     const char *file_out;
+    GraphBuilder builder;
     Graph graph;
+    ShapeStore shapes;
+    std::vector<Graph::Location> interior;
     std::map<osmium::object_id_type, std::uint32_t> link_counter;
 
 public:
@@ -35,7 +43,8 @@ public:
     Handler(const char* file) : 
         index_pos(), index_neg(),
         location_handler_type(index_pos, index_neg), 
-    	file_out(file), graph(), 
+    	file_out(file), builder(), graph(), 
+        shapes(), interior(),
         link_counter(),
         function(Function::CountNodes)
     {}
@@ -45,9 +54,7 @@ public:
         const osmium::TagList &tags = way.tags();
         const osmium::WayNodeList &nodelist = way.nodes();
 
-        if(tags.has_key("highway") && 
-            !tags.has_tag("highway", "path") && 
-            !tags.has_tag("highway", "pedestrian"))
+        if(is_routable(tags))
         {
             if(function == Function::CountNodes)
             {
@@ -60,7 +67,7 @@ public:
                     {
                         //then add location to graph
                         const osmium::Location loc = get_node_location(ref);
-                        graph.add_vertex(ref, {loc.lat(), loc.lon()});
+                        builder.add_vertex(ref, {loc.lat(), loc.lon()});
                     }
                 }
             }
@@ -71,52 +78,9 @@ public:
                 const bool oneway = tags.has_tag("oneway", "true");
                 const osmium::NodeRef *first = nullptr, *prev = nullptr;
                 double total_length = 0.0;
+                interior.clear();
                 
-                const char *speed_str = tags.get_value_by_key("maxspeed");
-                double speed = 30.0; //default speed in km/h
-                if (!speed_str) //not provided (majority)
-                {
-                    if (tags.has_tag("highway", "motorway"))
-                        speed = 120.0;
-                    else if (tags.has_tag("highway", "motorway_link"))
-                        speed = 120.0;
-                    else if (tags.has_tag("highway", "trunk"))
-                        speed = 100.0;
-                    else if (tags.has_tag("highway", "trunk_link"))
-                        speed = 100.0;
-                    else if (tags.has_tag("highway", "primary"))
-                        speed = 90.0;
-                    else if (tags.has_tag("highway", "primary_link"))
-                        speed = 90.0;
-                    else if (tags.has_tag("highway", "secondary"))
-                        speed = 70.0;
-                    else if (tags.has_tag("highway", "secondary_link"))
-                        speed = 70.0;
-                    else if (tags.has_tag("highway", "tertiary"))
-                        speed = 60.0;
-                    else if (tags.has_tag("highway", "tertiary_link"))
-                        speed = 60.0;
-                    else if (tags.has_tag("highway", "unclassified"))
-                        speed = 50.0;
-                    else if (tags.has_tag("highway", "residential"))
-                        speed = 30.0;
-                    else if (tags.has_tag("highway", "living_street"))
-                        speed = 10.0;
-                    else if(tags.has_tag("highway", "service"))
-                        speed = 30.0;
-                    else if (tags.has_tag("highway", "track"))
-                        speed = 30.0;
-                }
-                else if (const char *ptr = std::strstr(speed_str, "mph"))
-                    speed = std::atof(speed_str) * 1.60934;
-                else if (const char *ptr = std::strstr(speed_str, "knots"))
-                    speed = std::atof(speed_str) * 1.852;
-                else if (std::strncmp(speed_str, "none", std::strlen(speed_str)) == 0)
-                    speed = 180.0;
-                else if (std::strncmp(speed_str, "walk", std::strlen(speed_str)) == 0)
-                    speed = 5.0;
-                else //speed in km/h
-                    speed = std::atof(speed_str);
+                const double speed = way_speed(tags);
 
                 for (osmium::WayNodeList::const_iterator it = nodelist.cbegin();
                     it != nodelist.cend(); ++it)
@@ -145,11 +109,18 @@ public:
 
                     if (link_counter[node.ref()] > 1u)
                     {
-                        //construct an edge
-                        graph.add_edge(first->ref(), node.ref(), total_length / speed, oneway);
+                        //construct an edge, keeping the way nodes in between as its shape
+                        const osmium::Location l0 = get_node_location(first->ref());
+                        const Graph::shape_t shape = shapes.add({l0.lat(), l0.lon()}, interior);
+                        builder.add_edge(first->ref(), node.ref(), total_length / speed, oneway, shape);
                         total_length = 0.0;
+                        interior.clear();
                         first = &node;
                     }
+                    else
+                    {
+                        interior.push_back({l2.lat(), l2.lon()});
+                    }
                     
                     prev = &node;
                 }
@@ -158,9 +129,44 @@ public:
         }
     }
 
+    void preprocess()
+    {
+        const std::size_t builder_bytes = builder.memory_usage();
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+        graph = builder.freeze();
+        const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+        std::size_t vertices = graph.vertex_count(), edges = graph.edge_count();
+        std::cout << "Imported " << vertices << " vertices, " << edges << " edges. Froze " <<
+            (builder_bytes >> 20) << " MiB of builder buffers into a " << (graph.memory_usage() >> 20) <<
+            " MiB graph in " << duration.count() << "s.\n";
+
+        //islands and dead ends that the largest component cannot reach or leave
+        const std::size_t islands = graph.keep_largest_component();
+        std::cout << "Component filter removed " << islands << " vertices, " <<
+            (edges - graph.edge_count()) << " edges.\n";
+
+        vertices = graph.vertex_count();
+        edges = graph.edge_count();
+        graph.contract_chains(&shapes);
+        std::cout << "Chain contraction removed " << (vertices - graph.vertex_count()) << " vertices, " <<
+            (edges - graph.edge_count()) << " edges.\n";
+
+        //drop the shapes of removed edges
+        ShapeStore packed;
+        graph.repack_shapes(shapes, packed);
+        shapes = std::move(packed);
+
+        std::cout << "Final graph: " << graph.vertex_count() << " vertices, " << graph.edge_count() <<
+            " edges, " << shapes.byte_count() << " bytes of shapes." << std::endl;
+        std::cout << "Heuristic speed bound " << graph.heuristic_speed() << " km per unit of cost." << std::endl;
+        std::cout << "Peak resident memory " << (peak_resident_memory() >> 20) << " MiB." << std::endl;
+    }
+
     void output()
     {
         graph.output_binary(file_out);
+        shapes.output_binary((std::string(file_out) + ".geom").c_str());
     }
 
 }; 
@@ -175,6 +181,7 @@ int main(int argc, char **argv)
 
     try 
     {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
         Handler hnd(argv[2]);
         osmium::io::Reader reader1(argv[1], osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
         osmium::apply(reader1, hnd);
@@ -183,7 +190,11 @@ int main(int argc, char **argv)
         osmium::io::Reader reader2(argv[1], osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
         osmium::apply(reader2, hnd);
 
+        hnd.preprocess();
         hnd.output();
+
+        const std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+        std::cout << "Build took " << duration.count() << "s." << std::endl;
         
         return EXIT_SUCCESS;
     } 
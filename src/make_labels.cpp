@@ -0,0 +1,29 @@
+#include <chrono>
+#include <string>
+#include "graph.hpp"
+#include "hub_labels.hpp"
+
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::cerr << "1/2 arguments expected: file_input, (optional : file_output, by default file_input.hub)";
+        return EXIT_FAILURE;
+    }
+
+    Graph graph(argv[1]);
+    //results looks for each region's labels there
+    const std::string output = argc == 3 ? argv[2] : std::string(argv[1]) + ".hub";
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    const LabelStatistics stats = write_hub_labels(graph, output);
+    std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+    const double n = stats.vertices > 0u ? static_cast<double>(stats.vertices) : 1.0;
+    std::cout << stats.vertices << " vertices labelled in " << duration.count() << "s: " <<
+        stats.out_entries / n << " out and " << stats.in_entries / n << " in hubs per vertex on average, " <<
+        "largest labels " << stats.largest_out << " out and " << stats.largest_in << " in, " <<
+        stats.bytes / 1e6 << "MB (graph " << graph.memory_usage() / 1e6 << "MB)." << std::endl;
+
+    return EXIT_SUCCESS;
+}
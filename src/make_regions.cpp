@@ -0,0 +1,45 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include "graph.hpp"
+#include "graph_registry.hpp"
+
+//writes the region manifest read by GraphRegistry, so that it can start without loading any graph
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "2+ arguments expected: manifest_output, file_input (one or more .dat graphs)";
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream out(argv[1]);
+    if (!out)
+    {
+        std::cerr << "Could not write " << argv[1] << ".";
+        return EXIT_FAILURE;
+    }
+    out << std::setprecision(10);
+    //GraphRegistry reads the graphs relative to the manifest, not to where it was written from
+    const std::filesystem::path directory = std::filesystem::absolute(argv[1]).parent_path();
+
+    //one graph in memory at a time
+    for(int i = 2; i < argc; ++i)
+    {
+        const Graph graph(argv[i]);
+        if (graph.vertex_count() == 0u)
+        {
+            std::cerr << "Could not load graph " << argv[i] << ".";
+            return EXIT_FAILURE;
+        }
+
+        const GraphRegistry::Region region = describe_region(graph,
+            std::filesystem::proximate(argv[i], directory).string());
+        out << region.file << ' ' << region.min.lat << ' ' << region.min.lon << ' ' <<
+            region.max.lat << ' ' << region.max.lon << '\n';
+        std::cout << region.file << ": " << graph.vertex_count() << " vertices, (" << region.min << ") to (" <<
+            region.max << ")" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+#include "mapped_file.hpp"
+
+MappedFile::MappedFile()
+: base(nullptr), length(0u)
+{}
+
+MappedFile::MappedFile(const char *filename)
+: base(nullptr), length(0u)
+{
+	const int fd = ::open(filename, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (::fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void *p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			base = p;
+			length = static_cast<std::size_t>(st.st_size);
+		}
+	}
+
+	//the mapping stays valid after the descriptor is closed
+	::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+: base(other.base), length(other.length)
+{
+	other.base = nullptr;
+	other.length = 0u;
+}
+
+MappedFile& MappedFile::operator=(MappedFile &&other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(base, other.base);
+		std::swap(length, other.length);
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::is_open() const noexcept
+{
+	return base != nullptr;
+}
+
+std::size_t MappedFile::size() const noexcept
+{
+	return length;
+}
+
+const std::uint8_t* MappedFile::data() const noexcept
+{
+	return static_cast<const std::uint8_t*>(base);
+}
+
+void MappedFile::close() noexcept
+{
+	if (base)
+	{
+		::munmap(base, length);
+		base = nullptr;
+		length = 0u;
+	}
+}
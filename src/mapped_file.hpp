@@ -0,0 +1,55 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+//read-only memory mapping of a whole file
+class MappedFile
+{
+private:
+	void *base;
+	std::size_t length;
+
+public:
+	MappedFile();
+	MappedFile(const char*);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) noexcept;
+	MappedFile& operator=(MappedFile&&) noexcept;
+	~MappedFile();
+
+	bool is_open() const noexcept;
+	std::size_t size() const noexcept;
+	const std::uint8_t* data() const noexcept;
+	void close() noexcept;
+};
+
+//files meant to be mapped start every array 8-byte aligned, so it can be used in place
+inline std::size_t padded(std::size_t bytes)
+{
+	return (bytes + 7) / 8 * 8;
+}
+
+template<typename T>
+void write_array(std::ostream &out, const std::vector<T> &values)
+{
+	static const char zeros[8] = {};
+	const std::size_t bytes = values.size() * sizeof(T);
+	out.write(reinterpret_cast<const char*>(values.data()), bytes);
+	out.write(zeros, padded(bytes) - bytes);
+}
+
+//the array at p, moving p past it and its padding
+template<typename T>
+const T* read_array(const std::uint8_t *&p, std::size_t count)
+{
+	const T *array = reinterpret_cast<const T*>(p);
+	p += padded(count * sizeof(T));
+	return array;
+}
+
+#endif //MAPPED_FILE_HPP
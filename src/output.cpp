@@ -0,0 +1,345 @@
+#include <charconv>
+#include "output.hpp"
+#include "geometry.hpp"
+
+constexpr std::size_t BufferedWriter::DEFAULT_CAPACITY;
+
+BufferedWriter::BufferedWriter(const char *filename, std::size_t capacity)
+: owned(new std::ofstream(filename, std::ios::binary)), out(owned.get()),
+	buffer(capacity), used(0u)
+{}
+
+BufferedWriter::BufferedWriter(std::ostream &stream, std::size_t capacity)
+: owned(), out(&stream), buffer(capacity), used(0u)
+{}
+
+BufferedWriter::~BufferedWriter()
+{
+	flush();
+}
+
+bool BufferedWriter::good() const
+{
+	return out->good();
+}
+
+void BufferedWriter::flush()
+{
+	if (used > 0u)
+	{
+		out->write(buffer.data(), used);
+		used = 0u;
+	}
+	out->flush();
+}
+
+void BufferedWriter::put(std::int64_t value)
+{
+	char digits[24];
+	const std::to_chars_result r = std::to_chars(digits, digits + sizeof(digits), value);
+	write(digits, r.ptr - digits);
+}
+
+void BufferedWriter::put(std::uint64_t value)
+{
+	char digits[24];
+	const std::to_chars_result r = std::to_chars(digits, digits + sizeof(digits), value);
+	write(digits, r.ptr - digits);
+}
+
+void BufferedWriter::put(double value, int precision)
+{
+	//negative precision: shortest representation that round-trips
+	char digits[64];
+	const std::to_chars_result r = precision < 0 ?
+		std::to_chars(digits, digits + sizeof(digits), value) :
+		std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, precision);
+	write(digits, r.ptr - digits);
+}
+
+Format format_from_filename(const std::string &filename)
+{
+	const std::size_t dot = filename.rfind('.');
+	const std::string ext = dot == std::string::npos ? std::string() : filename.substr(dot + 1);
+
+	if (ext == "kml")
+		return Format::KML;
+	if (ext == "geojson" || ext == "json")
+		return Format::GeoJSON;
+	if (ext == "csv")
+		return Format::CSV;
+	if (ext == "bin")
+		return Format::Binary;
+	if (ext == "txt")
+		return Format::Text;
+	return Format::Polyline;
+}
+
+//degrees to 1e-7, the precision of the OSM source data
+static const int COORDINATE_DIGITS = 7;
+//"PTH1"
+static const std::uint32_t PATH_MAGIC = 0x31485450;
+
+static void put_lon_lat(BufferedWriter &w, const Graph::Location &l, char separator)
+{
+	w.put(l.lon, COORDINATE_DIGITS);
+	w.put(separator);
+	w.put(l.lat, COORDINATE_DIGITS);
+}
+
+static void write_binary(BufferedWriter &w, const std::vector<Graph::Location> &points)
+{
+	const std::uint32_t header[2] = {PATH_MAGIC, 0u};
+	const std::uint64_t count = points.size();
+
+	w.put_raw(header, sizeof(header));
+	w.put_raw(&count, sizeof(count));
+	w.put_raw(points.data(), points.size() * sizeof(Graph::Location));
+}
+
+static void write_csv(BufferedWriter &w, const std::vector<Graph::Location> &points)
+{
+	w.put("lat,lon\n");
+	for(const Graph::Location &l : points)
+	{
+		w.put(l.lat, COORDINATE_DIGITS);
+		w.put(',');
+		w.put(l.lon, COORDINATE_DIGITS);
+		w.put('\n');
+	}
+}
+
+static void write_kml_header(BufferedWriter &w, const char *color)
+{
+	w.put(
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<kml xmlns=\"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+	"<Document>\n"
+	  "<name>LineStyle.kml</name>\n"
+	  "<open>1</open>\n"
+	  "<Style id=\"linestyleExample\">\n"
+	    "<LineStyle>\n"
+	      "<color>");
+	w.put(color);
+	w.put("</color>\n"
+	      "<width>4</width>\n"
+	      "<gx:labelVisibility>1</gx:labelVisibility>\n"
+	    "</LineStyle>\n"
+	  "</Style>\n");
+}
+
+void write_path(BufferedWriter &w, Format format, const std::vector<Graph::Location> &points,
+	const char *color)
+{
+	switch (format)
+	{
+	case Format::KML:
+		write_kml_header(w, color);
+		w.put(
+		  "<Placemark>\n"
+		    "<name>LineStyle Example</name>\n"
+		    "<styleUrl>#linestyleExample</styleUrl>\n"
+		    "<LineString>\n"
+		      "<extrude>1</extrude>\n"
+		      "<tessellate>1</tessellate>\n"
+		      "<coordinates>\n");
+		for(const Graph::Location &l : points)
+		{
+			put_lon_lat(w, l, ',');
+			w.put(",0\n");
+		}
+		w.put(
+		"</coordinates>\n"
+		"</LineString>\n"
+		  "</Placemark>\n"
+		"</Document>\n"
+		"</kml>");
+		break;
+
+	case Format::GeoJSON:
+		w.put("{\"type\":\"Feature\",\"properties\":{},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[");
+		for(std::size_t i = 0u; i < points.size(); ++i)
+		{
+			w.put(i > 0u ? ",[" : "[");
+			put_lon_lat(w, points[i], ',');
+			w.put(']');
+		}
+		w.put("]}}\n");
+		break;
+
+	case Format::CSV:
+	case Format::Text:
+		write_csv(w, points);
+		break;
+
+	case Format::Binary:
+		write_binary(w, points);
+		break;
+
+	case Format::Polyline:
+		w.put(encode_polyline(points));
+		w.put('\n');
+		break;
+	}
+}
+
+void write_points(BufferedWriter &w, Format format, const std::vector<Graph::Location> &points)
+{
+	switch (format)
+	{
+	case Format::KML:
+		write_kml_header(w, "7f00ff00");
+		for(const Graph::Location &l : points)
+		{
+			w.put("<Placemark><Point><coordinates>");
+			put_lon_lat(w, l, ',');
+			w.put("</coordinates></Point></Placemark>\n");
+		}
+		w.put(
+		"</Document>\n"
+		"</kml>");
+		break;
+
+	case Format::GeoJSON:
+		w.put("{\"type\":\"Feature\",\"properties\":{},\"geometry\":{\"type\":\"MultiPoint\",\"coordinates\":[");
+		for(std::size_t i = 0u; i < points.size(); ++i)
+		{
+			w.put(i > 0u ? ",[" : "[");
+			put_lon_lat(w, points[i], ',');
+			w.put(']');
+		}
+		w.put("]}}\n");
+		break;
+
+	case Format::Binary:
+		write_binary(w, points);
+		break;
+
+	default:
+		write_csv(w, points);
+		break;
+	}
+}
+
+//"GRF1"
+static const std::uint32_t GRAPH_MAGIC = 0x31465247;
+
+//a two-way road is drawn once: v to w is skipped when w to v exists and w < v
+static bool drawn_edge(const Graph &graph, Graph::index_t v, Graph::index_t w)
+{
+	if (v < w)
+		return true;
+	for(const Graph::Edge &e : graph.out_edges(w))
+	{
+		if (e.destination == v)
+			return false;
+	}
+	return true;
+}
+
+void write_graph(BufferedWriter &w, Format format, const Graph &graph)
+{
+	const Graph::index_t n = static_cast<Graph::index_t>(graph.ids.size());
+
+	switch (format)
+	{
+	case Format::KML:
+		write_kml_header(w, "7f0000ff");
+		w.put("<Placemark>\n<styleUrl>#linestyleExample</styleUrl>\n<MultiGeometry>\n");
+		for(Graph::index_t v = 0u; v < n; ++v)
+		{
+			for(Graph::index_t e = graph.first_edge[v]; e < graph.first_edge[v + 1]; ++e)
+			{
+				const Graph::index_t to = graph.edges[e].destination;
+				if (!drawn_edge(graph, v, to))
+					continue;
+				w.put("<LineString><coordinates>");
+				put_lon_lat(w, graph.locations[v], ',');
+				w.put(' ');
+				put_lon_lat(w, graph.locations[to], ',');
+				w.put("</coordinates></LineString>\n");
+			}
+		}
+		w.put(
+		"</MultiGeometry>\n"
+		"</Placemark>\n"
+		"</Document>\n"
+		"</kml>");
+		break;
+
+	case Format::GeoJSON:
+	{
+		w.put("{\"type\":\"Feature\",\"properties\":{},\"geometry\":{\"type\":\"MultiLineString\",\"coordinates\":[");
+		bool first = true;
+		for(Graph::index_t v = 0u; v < n; ++v)
+		{
+			for(Graph::index_t e = graph.first_edge[v]; e < graph.first_edge[v + 1]; ++e)
+			{
+				const Graph::index_t to = graph.edges[e].destination;
+				if (!drawn_edge(graph, v, to))
+					continue;
+				w.put(first ? "[[" : ",[[");
+				put_lon_lat(w, graph.locations[v], ',');
+				w.put("],[");
+				put_lon_lat(w, graph.locations[to], ',');
+				w.put("]]");
+				first = false;
+			}
+		}
+		w.put("]}}\n");
+		break;
+	}
+
+	case Format::CSV:
+		w.put("from,to,cost\n");
+		for(Graph::index_t v = 0u; v < n; ++v)
+		{
+			for(Graph::index_t e = graph.first_edge[v]; e < graph.first_edge[v + 1]; ++e)
+			{
+				w.put(graph.ids[v]);
+				w.put(',');
+				w.put(graph.ids[graph.edges[e].destination]);
+				w.put(',');
+				w.put(graph.edges[e].cost, -1);
+				w.put('\n');
+			}
+		}
+		break;
+
+	case Format::Binary:
+	{
+		//the CSR arrays as they are in memory
+		const std::uint32_t header[2] = {GRAPH_MAGIC, 0u};
+		const std::uint64_t counts[2] = {graph.ids.size(), graph.edges.size()};
+		w.put_raw(header, sizeof(header));
+		w.put_raw(counts, sizeof(counts));
+		w.put_raw(graph.ids.data(), graph.ids.size() * sizeof(Graph::id_t));
+		w.put_raw(graph.locations.data(), graph.locations.size() * sizeof(Graph::Location));
+		w.put_raw(graph.first_edge.data(), graph.first_edge.size() * sizeof(Graph::index_t));
+		w.put_raw(graph.edges.data(), graph.edges.size() * sizeof(Graph::Edge));
+		break;
+	}
+
+	case Format::Text:
+	case Format::Polyline:
+		for(Graph::index_t v = 0u; v < n; ++v)
+		{
+			w.put(graph.ids[v]);
+			w.put(": ");
+			w.put(graph.locations[v].lat, -1);
+			w.put(", ");
+			w.put(graph.locations[v].lon, -1);
+			w.put("\n{");
+			for(Graph::index_t e = graph.first_edge[v]; e < graph.first_edge[v + 1]; ++e)
+			{
+				w.put('(');
+				w.put(graph.ids[graph.edges[e].destination]);
+				w.put(", ");
+				w.put(graph.edges[e].cost, -1);
+				w.put("), ");
+			}
+			w.put("}\n");
+		}
+		break;
+	}
+}
@@ -0,0 +1,95 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "graph.hpp"
+
+//large write buffer in front of a stream; only full buffers reach the stream
+class BufferedWriter
+{
+private:
+	constexpr static std::size_t DEFAULT_CAPACITY = 1u << 20;
+
+	std::unique_ptr<std::ofstream> owned;
+	std::ostream *out;
+	std::vector<char> buffer;
+	std::size_t used;
+
+public:
+	BufferedWriter(const char*, std::size_t = DEFAULT_CAPACITY);
+	BufferedWriter(std::ostream&, std::size_t = DEFAULT_CAPACITY);
+	BufferedWriter(const BufferedWriter&) = delete;
+	BufferedWriter& operator=(const BufferedWriter&) = delete;
+	~BufferedWriter();
+
+	bool good() const;
+	void flush();
+	void write(const char*, std::size_t);
+	void put(char);
+	void put(const char*);
+	void put(const std::string&);
+	void put(std::int64_t);
+	void put(std::uint64_t);
+	void put(double, int);
+	void put_raw(const void*, std::size_t);
+};
+
+inline void BufferedWriter::write(const char *data, std::size_t n)
+{
+	if (used + n > buffer.size())
+	{
+		flush();
+		if (n > buffer.size())
+		{
+			out->write(data, n);
+			return;
+		}
+	}
+	std::memcpy(buffer.data() + used, data, n);
+	used += n;
+}
+
+inline void BufferedWriter::put(char c)
+{
+	if (used == buffer.size())
+		flush();
+	buffer[used++] = c;
+}
+
+inline void BufferedWriter::put(const char *s)
+{
+	write(s, std::strlen(s));
+}
+
+inline void BufferedWriter::put(const std::string &s)
+{
+	write(s.data(), s.size());
+}
+
+inline void BufferedWriter::put_raw(const void *data, std::size_t n)
+{
+	write(static_cast<const char*>(data), n);
+}
+
+enum class Format
+{
+	Text, KML, GeoJSON, CSV, Binary, Polyline
+};
+
+//chosen from the file extension, encoded polyline when unrecognised
+Format format_from_filename(const std::string&);
+
+//a route as a single line
+void write_path(BufferedWriter&, Format, const std::vector<Graph::Location>&, const char* = "7f0000ff");
+
+//an unordered set of locations, e.g. the vertices settled within a budget
+void write_points(BufferedWriter&, Format, const std::vector<Graph::Location>&);
+
+//every vertex and edge: KML and GeoJSON draw each road once as a straight segment, CSV is one edge per row,
+//Binary the raw CSR arrays ("GRF1"), Text (and Polyline) the listing of operator<<
+void write_graph(BufferedWriter&, Format, const Graph&);
+
+#endif //OUTPUT_HPP
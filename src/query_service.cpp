@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "query_service.hpp"
+#include "search.hpp"
+
+constexpr std::size_t QueryService::LATENCY_SAMPLES;
+
+static const std::size_t CACHE_SHARDS = 16u;
+
+//a missing or unreadable file loads as an empty graph, which no query could be snapped to
+static std::shared_ptr<const Graph> read_graph(const char *filename)
+{
+	std::shared_ptr<const Graph> graph = std::make_shared<const Graph>(filename);
+	if (graph->vertex_count() == 0u)
+		throw std::runtime_error(std::string("Could not load graph ") + filename);
+	return graph;
+}
+
+QueryService::QueryService(const char *filename, std::size_t threads, double snap_resolution,
+	std::size_t snap_capacity, std::size_t route_capacity)
+: resolution(snap_resolution), graph_mutex(), graph(read_graph(filename)), generation(1u),
+	snaps(snap_capacity, CACHE_SHARDS), routes(route_capacity, CACHE_SHARDS),
+	flight_mutex(), in_flight(), queue_mutex(), queue_changed(), tasks(), stopping(false), workers(),
+	n_requests(0u), n_hits(0u), n_coalesced(0u), n_computed(0u),
+	latency_mutex(), latencies(LATENCY_SAMPLES, 0.0), latency_count(0u)
+{
+	threads = std::max<std::size_t>(1u, threads);
+	for(std::size_t t = 0u; t < threads; ++t)
+		workers.emplace_back(&QueryService::work, this);
+}
+
+QueryService::~QueryService()
+{
+	//queued queries still run, so every future handed out is fulfilled
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		stopping = true;
+	}
+	queue_changed.notify_all();
+
+	for(std::thread &t : workers)
+		t.join();
+}
+
+void QueryService::work()
+{
+	for(;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_changed.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+std::uint64_t QueryService::cell_key(Graph::Location l) const
+{
+	//coordinates within one cell of the snapping grid share a key
+	const std::int32_t lat = static_cast<std::int32_t>(std::llround(l.lat / resolution));
+	const std::int32_t lon = static_cast<std::int32_t>(std::llround(l.lon / resolution));
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(lat)) << 32) | static_cast<std::uint32_t>(lon);
+}
+
+Graph::Location QueryService::cell_centre(std::uint64_t key) const
+{
+	const std::int32_t lat = static_cast<std::int32_t>(static_cast<std::uint32_t>(key >> 32));
+	const std::int32_t lon = static_cast<std::int32_t>(static_cast<std::uint32_t>(key));
+	return {lat * resolution, lon * resolution};
+}
+
+std::shared_ptr<const Graph> QueryService::current_graph(std::uint64_t &loaded)
+{
+	std::lock_guard<std::mutex> lock(graph_mutex);
+	loaded = generation;
+	return graph;
+}
+
+std::shared_ptr<const Graph> QueryService::current_graph()
+{
+	std::uint64_t loaded;
+	return current_graph(loaded);
+}
+
+Graph::index_t QueryService::snap(const Graph &g, std::uint64_t cell, std::uint64_t loaded)
+{
+	//the vertex nearest the cell centre, so every coordinate in the cell snaps alike
+	Snap s;
+	if (snaps.get(cell, s) && s.generation == loaded)
+		return s.vertex;
+
+	const Graph::index_t v = g.index_of(g.from_location(cell_centre(cell)));
+	snaps.put(cell, {v, loaded});
+	return v;
+}
+
+QueryService::RoutePtr QueryService::compute(std::uint64_t from_cell, std::uint64_t to_cell)
+{
+	std::uint64_t loaded;
+	const std::shared_ptr<const Graph> g = current_graph(loaded);
+	const Graph::index_t source = snap(*g, from_cell, loaded), target = snap(*g, to_cell, loaded);
+	const std::uint64_t key = (static_cast<std::uint64_t>(source) << 32) | target;
+
+	//other coordinates may have snapped to the same vertices already
+	RoutePtr cached;
+	if (routes.get(key, cached) && cached->generation == loaded)
+	{
+		n_hits++;
+		return cached;
+	}
+
+	std::shared_ptr<Route> route = std::make_shared<Route>();
+	route->found = false;
+	route->cost = 0.0;
+	route->generation = loaded;
+
+	//one space per worker thread, reused from query to query
+	SearchSpace &space = thread_search_space(g->vertex_count());
+	NullVisitor visitor;
+	if (search<BinaryHeap>(*g, source, space, GreatCircleHeuristic(*g, target), StopAtTarget{target}, visitor) !=
+		Graph::NO_INDEX)
+	{
+		route->found = true;
+		route->cost = space.cost[target];
+		for(Graph::index_t v = target; v != source; v = space.parent[v])
+			route->path.push_back(g->vertex_id(v));
+		route->path.push_back(g->vertex_id(source));
+		std::reverse(route->path.begin(), route->path.end());
+	}
+	space.reset();
+
+	n_computed++;
+	routes.put(key, route);
+	return route;
+}
+
+std::shared_future<QueryService::RoutePtr> QueryService::route(Graph::Location from, Graph::Location to)
+{
+	const TimePoint start = std::chrono::steady_clock::now();
+	const std::uint64_t from_cell = cell_key(from), to_cell = cell_key(to);
+	const std::uint64_t loaded = generation;
+	n_requests++;
+
+	//answered on the caller's thread when both ends are snapped and the route is cached
+	Snap a, b;
+	RoutePtr cached;
+	if (snaps.get(from_cell, a) && a.generation == loaded && snaps.get(to_cell, b) && b.generation == loaded &&
+		routes.get((static_cast<std::uint64_t>(a.vertex) << 32) | b.vertex, cached) && cached->generation == loaded)
+	{
+		n_hits++;
+		record_latency(start);
+		std::promise<RoutePtr> ready;
+		ready.set_value(cached);
+		return ready.get_future().share();
+	}
+
+	const FlightKey key(loaded, {from_cell, to_cell});
+	std::shared_ptr<std::promise<RoutePtr>> promise;
+	std::shared_future<RoutePtr> result;
+	{
+		std::lock_guard<std::mutex> lock(flight_mutex);
+		auto it = in_flight.find(key);
+		if (it != in_flight.end())
+		{
+			n_coalesced++;
+			it->second.waiting.push_back(start);
+			return it->second.result;
+		}
+
+		promise = std::make_shared<std::promise<RoutePtr>>();
+		InFlight &flight = in_flight[key];
+		flight.result = promise->get_future().share();
+		flight.waiting.push_back(start);
+		result = flight.result;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		tasks.push_back([this, promise, key]()
+		{
+			try
+			{
+				promise->set_value(compute(key.second.first, key.second.second));
+			}
+			catch (...)
+			{
+				promise->set_exception(std::current_exception());
+			}
+
+			std::vector<TimePoint> waiting;
+			{
+				std::lock_guard<std::mutex> lock(flight_mutex);
+				auto it = in_flight.find(key);
+				waiting.swap(it->second.waiting);
+				in_flight.erase(it);
+			}
+			for(TimePoint t : waiting)
+				record_latency(t);
+		});
+	}
+	queue_changed.notify_one();
+
+	return result;
+}
+
+void QueryService::reload(const char *filename)
+{
+	//loaded outside the lock; queries keep running on the old graph meanwhile, and after a failed load
+	std::shared_ptr<const Graph> fresh = read_graph(filename);
+	{
+		std::lock_guard<std::mutex> lock(graph_mutex);
+		graph = fresh;
+		generation++;
+	}
+
+	//entries are also stamped with their generation, this only releases the memory
+	snaps.clear();
+	routes.clear();
+}
+
+void QueryService::record_latency(QueryService::TimePoint start)
+{
+	const std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+	std::lock_guard<std::mutex> lock(latency_mutex);
+	latencies[latency_count % LATENCY_SAMPLES] = latency.count();
+	latency_count++;
+}
+
+QueryService::Statistics QueryService::statistics()
+{
+	std::vector<double> samples;
+	{
+		std::lock_guard<std::mutex> lock(latency_mutex);
+		samples.assign(latencies.begin(), latencies.begin() + std::min(latency_count, LATENCY_SAMPLES));
+	}
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&samples](double p)
+	{
+		if (samples.empty())
+			return 0.0;
+		const std::size_t rank = static_cast<std::size_t>(std::ceil(p * samples.size()));
+		return samples[std::max<std::size_t>(rank, 1u) - 1];
+	};
+
+	return {n_requests, n_hits, n_coalesced, n_computed, routes.size(),
+		percentile(0.5), percentile(0.9), percentile(0.99), samples.empty() ? 0.0 : samples.back()};
+}
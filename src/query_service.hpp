@@ -0,0 +1,118 @@
+#ifndef QUERY_SERVICE_HPP
+#define QUERY_SERVICE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "graph.hpp"
+#include "lru_cache.hpp"
+
+//asynchronous point-to-point routing over a shared graph: answers come from a cache, join an identical
+//query already running, or are computed on a worker thread
+class QueryService
+{
+public:
+	struct Route
+	{
+		bool found;
+		Graph::cost_t cost;
+		std::vector<Graph::id_t> path;
+		std::uint64_t generation; //graph load that produced it
+	};
+
+	typedef std::shared_ptr<const Route> RoutePtr;
+
+	struct Statistics
+	{
+		std::uint64_t requests;
+		std::uint64_t hits;
+		std::uint64_t coalesced;
+		std::uint64_t computed;
+		std::size_t cached_routes;
+		//request to answer, over the most recent requests
+		double p50;
+		double p90;
+		double p99;
+		double max;
+	};
+
+private:
+	typedef std::chrono::time_point<std::chrono::steady_clock> TimePoint;
+
+	struct Snap
+	{
+		Graph::index_t vertex;
+		std::uint64_t generation;
+	};
+
+	//callers waiting on one computation, kept to time each of them
+	struct InFlight
+	{
+		std::shared_future<RoutePtr> result;
+		std::vector<TimePoint> waiting;
+	};
+
+	constexpr static std::size_t LATENCY_SAMPLES = 1u << 16;
+
+	double resolution;
+
+	std::mutex graph_mutex;
+	std::shared_ptr<const Graph> graph;
+	std::atomic<std::uint64_t> generation;
+
+	ShardedLru<Snap> snaps;
+	ShardedLru<RoutePtr> routes;
+
+	//keyed by generation, then the snapping cells of both ends
+	typedef std::pair<std::uint64_t, std::pair<std::uint64_t, std::uint64_t>> FlightKey;
+
+	std::mutex flight_mutex;
+	std::map<FlightKey, InFlight> in_flight;
+
+	std::mutex queue_mutex;
+	std::condition_variable queue_changed;
+	std::deque<std::function<void()>> tasks;
+	bool stopping;
+	std::vector<std::thread> workers;
+
+	std::atomic<std::uint64_t> n_requests;
+	std::atomic<std::uint64_t> n_hits;
+	std::atomic<std::uint64_t> n_coalesced;
+	std::atomic<std::uint64_t> n_computed;
+
+	std::mutex latency_mutex;
+	std::vector<double> latencies; //ring buffer
+	std::size_t latency_count;
+
+	std::uint64_t cell_key(Graph::Location) const;
+	Graph::Location cell_centre(std::uint64_t) const;
+	std::shared_ptr<const Graph> current_graph(std::uint64_t&);
+	Graph::index_t snap(const Graph&, std::uint64_t, std::uint64_t);
+	RoutePtr compute(std::uint64_t, std::uint64_t);
+	void record_latency(TimePoint);
+	void work();
+
+public:
+	//snapping resolution in degrees, cache capacities in entries; throws if the graph cannot be read
+	QueryService(const char*, std::size_t = std::thread::hardware_concurrency(), double = 1e-4,
+		std::size_t = 1u << 16, std::size_t = 1u << 18);
+	QueryService(const QueryService&) = delete;
+	QueryService& operator=(const QueryService&) = delete;
+	~QueryService();
+
+	std::shared_future<RoutePtr> route(Graph::Location, Graph::Location);
+	//swaps in a freshly loaded graph; routes cached or snapped on the old one are never served again.
+	//throws if the file cannot be read, leaving the old graph in service
+	void reload(const char*);
+	std::shared_ptr<const Graph> current_graph();
+	Statistics statistics();
+};
+
+#endif //QUERY_SERVICE_HPP
@@ -1,6 +1,10 @@
 #include <chrono>
 #include <cstring>
+#include <map>
+#include <memory>
 #include "graph.hpp"
+#include "graph_registry.hpp"
+#include "hub_labels.hpp"
 
 #define ROWS 10
 #define COLUMNS 2
@@ -23,9 +27,9 @@ static const Graph::Location coordinates[ROWS][COLUMNS] =
 
 int main(int argc, char **argv)
 {
-    if (argc != 2)
+    if (argc != 3)
     {
-        std::cerr << "Argument expected: number of trials.";
+        std::cerr << "2 arguments expected: number of trials, file_input (graph or region manifest)";
         return EXIT_FAILURE;
     }
 
@@ -37,8 +41,43 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    Graph graph("data/england.dat");
+    //rows are matched to regions up front, and every region needed loads in the background meanwhile
+    std::unique_ptr<GraphRegistry> registry;
+    std::size_t regions[ROWS];
+    //each region's labels are read from its file + ".hub"
+    std::map<std::size_t, std::unique_ptr<const HubLabels>> labels;
+    try
+    {
+        registry.reset(new GraphRegistry(argv[2], 0u, 2u));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << ".";
+        return EXIT_FAILURE;
+    }
+    for(int i = 0; i < ROWS; ++i)
+    {
+        regions[i] = registry->locate(coordinates[i][0], coordinates[i][1]);
+        if (regions[i] == GraphRegistry::NO_REGION)
+        {
+            std::cerr << "No region listed in " << argv[2] << ".";
+            return EXIT_FAILURE;
+        }
+        registry->preload(regions[i]);
+
+        std::unique_ptr<const HubLabels> &region_labels = labels[regions[i]];
+        if (!region_labels)
+            region_labels.reset(new HubLabels((registry->region(regions[i]).file + ".hub").c_str()));
+    }
+
+    //a third set of timings per row when any region has labels, so every row is equally wide; rows whose
+    //labels are missing or built from another graph print '-' there
+    bool with_labels = false;
+    for(const auto &region_labels : labels)
+        with_labels = with_labels || region_labels.second->is_open();
+
     std::map<Graph::id_t, Graph::id_t> came_from;
+    bool local = false;
 
     std::chrono::time_point<std::chrono::high_resolution_clock> start, stop;
     std::chrono::duration<double> duration;
@@ -46,9 +85,24 @@ int main(int argc, char **argv)
 
     for(int i = 0; i < ROWS; ++i)
     {
+        GraphRegistry::GraphPtr graph_ptr;
+        try
+        {
+            graph_ptr = registry->acquire(regions[i]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << ".";
+            return EXIT_FAILURE;
+        }
+        const Graph &graph = *graph_ptr;
+
+        const HubLabels &region_labels = *labels[regions[i]];
+        const bool use_labels = region_labels.matches(graph);
+
         const Graph::id_t v1 = graph.from_location(coordinates[i][0]);
         const Graph::id_t v2 = graph.from_location(coordinates[i][1]);
-        
+
         for(int t = 0; t < trials; ++t)
         {
             start = std::chrono::high_resolution_clock::now();
@@ -74,6 +128,28 @@ int main(int argc, char **argv)
             else
                 std::cout << duration.count() << '\t';
         }
+
+        for(int t = 0; t < trials && with_labels && !use_labels; ++t)
+            std::cout << "-\t";
+
+        if (use_labels)
+        {
+            const DistanceOracle oracle(graph, region_labels);
+
+            for(int t = 0; t < trials; ++t)
+            {
+                start = std::chrono::high_resolution_clock::now();
+                found = oracle.distance(graph.index_of(v1), graph.index_of(v2), local) <
+                    std::numeric_limits<Graph::cost_t>::infinity();
+                stop = std::chrono::high_resolution_clock::now();
+                duration = stop - start;
+
+                if(!found)
+                    not_found(i, t, 2);
+                else
+                    std::cout << duration.count() << '\t';
+            }
+        }
     }
     
 
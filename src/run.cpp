@@ -1,17 +1,55 @@
 #include <chrono>
+#include <cstring>
+#include <string>
 #include "graph.hpp"
+#include "cells.hpp"
+#include "geometry.hpp"
+#include "graph_registry.hpp"
+#include "output.hpp"
+
+static int route_cells(int, char**);
 
 int main(int argc, char **argv)
 {
-	if (argc != 7 && argc != 8)
+	if (argc < 7 || argc > 9)
 	{
-		std::cerr << "6/7 arguments expected: file_input, dijkstra/astar/locate, lat1, lon1, lat2, lon2, (optional : file_output_kml)";
+		std::cerr << "6/7/8 arguments expected: file_input (graph, region manifest, or cells directory for cells), dijkstra/astar/cells/locate, lat1, lon1, lat2, lon2, "
+            "(optional : file_output .kml/.geojson/.csv/.bin/polyline), (optional : simplify tolerance in metres)";
         return EXIT_FAILURE;
 	}
 
-	Graph graph(argv[1]);
-	Graph::id_t v1 = graph.from_location({std::atof(argv[3]), std::atof(argv[4])});
-    Graph::id_t v2 = graph.from_location({std::atof(argv[5]), std::atof(argv[6])});
+    if (std::strncmp(argv[2], "cells", std::strlen(argv[2])) == 0)
+    {
+        return route_cells(argc, argv);
+    }
+
+    //a manifest lists several regions, of which only the one covering both ends is loaded
+    const Graph::Location from = {std::atof(argv[3]), std::atof(argv[4])};
+    const Graph::Location to = {std::atof(argv[5]), std::atof(argv[6])};
+    std::unique_ptr<GraphRegistry> registry;
+    std::size_t region = GraphRegistry::NO_REGION;
+    GraphRegistry::GraphPtr graph_ptr;
+
+    try
+    {
+        registry.reset(new GraphRegistry(argv[1]));
+        region = registry->locate(from, to);
+        if (region == GraphRegistry::NO_REGION)
+        {
+            std::cerr << "No region listed in " << argv[1] << ".";
+            return EXIT_FAILURE;
+        }
+        graph_ptr = registry->acquire(region);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << ".";
+        return EXIT_FAILURE;
+    }
+
+    const Graph &graph = *graph_ptr;
+	Graph::id_t v1 = graph.from_location(from);
+    Graph::id_t v2 = graph.from_location(to);
     std::map<Graph::id_t, Graph::id_t> came_from;
 
     bool dijkstra_or_astar = true;
@@ -33,7 +71,7 @@ int main(int argc, char **argv)
     }
     else
     {
-        std::cerr << "Enter either \"dijkstra\" or \"astar\" or \"locate\" as 2nd argument.";
+        std::cerr << "Enter either \"dijkstra\" or \"astar\" or \"cells\" or \"locate\" as 2nd argument.";
         return EXIT_FAILURE;
     }
 
@@ -57,49 +95,69 @@ int main(int argc, char **argv)
     std::chrono::duration<double> duration = stop - start;
     std::cout << duration.count() << "s" << std::endl;
 
-    if (argc == 8) //extra argument: output kml
+    if (argc >= 8) //extra arguments: output file, simplification tolerance
     {
-        std::vector<Graph::id_t> vlist = graph.reconstruct_path(v1, v2, came_from);
-
-        std::ofstream kml_out(argv[7]);
-        kml_out << 
-        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" <<
-        "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n" <<
-        "<Document>\n" <<
-          "<name>LineStyle.kml</name>\n" <<
-          "<open>1</open>\n" <<
-          "<Style id=\"linestyleExample\">\n" <<
-            "<LineStyle>\n" <<
-              "<color>" << (dijkstra_or_astar ? "7f0000ff" : "7fff0000") << "</color>\n" <<
-              "<width>4</width>\n" <<
-              "<gx:labelVisibility>1</gx:labelVisibility>\n" <<
-            "</LineStyle>\n" <<
-          "</Style>\n" <<
-          "<Placemark>\n" <<
-            "<name>LineStyle Example</name>\n" <<
-            "<styleUrl>#linestyleExample</styleUrl>\n" <<
-            "<LineString>\n" <<
-              "<extrude>1</extrude>\n" <<
-              "<tessellate>1</tessellate>\n" <<
-              "<coordinates>\n";
-        
-        for(const Graph::id_t& v : vlist)
-        {
-            const Graph::Location l = graph.location(v);
-            kml_out << l.lon << "," << l.lat << ",0" << std::endl;
-        }
-        const Graph::Location l = graph.location(vlist.front());
-        kml_out << l.lon << "," << l.lat << ",0" << std::endl;
+        const std::vector<Graph::id_t> vlist = graph.reconstruct_path(v1, v2, came_from);
+        const ShapeStore shapes((registry->region(region).file + ".geom").c_str());
+
+        std::vector<Graph::Location> points;
+        unpack_path(graph, shapes, vlist, [&points](Graph::Location l) { points.push_back(l); });
 
-        kml_out << 
-        "</coordinates>\n" <<
-        "</LineString>\n" <<
-          "</Placemark>\n" <<
-        "</Document>\n" <<
-        "</kml>";
+        if (argc == 9)
+            points = simplify(points, std::atof(argv[8]));
 
-        kml_out.close();
+        BufferedWriter out(argv[7]);
+        write_path(out, format_from_filename(argv[7]), points, dijkstra_or_astar ? "7f0000ff" : "7fff0000");
     }
 
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+//routes over a directory written by make_cells, mapping only the cells the query touches
+int route_cells(int argc, char **argv)
+{
+    CellRouter router(argv[1]);
+    if (!router.is_open())
+    {
+        std::cerr << "No cell overlay found in " << argv[1] << ".";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<CellRouter::Step> steps;
+    Graph::cost_t cost = 0.0;
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    const bool found = router.route({std::atof(argv[3]), std::atof(argv[4])},
+        {std::atof(argv[5]), std::atof(argv[6])}, cost, steps);
+    std::chrono::time_point<std::chrono::high_resolution_clock> stop = std::chrono::high_resolution_clock::now();
+
+    if (!found)
+    {
+        std::cerr << "The path was not found.";
+        return EXIT_FAILURE;
+    }
+
+    std::chrono::duration<double> duration = stop - start;
+    std::cout << duration.count() << "s" << std::endl;
+    std::cout << "Cost " << cost << ", " << router.loaded_cells() << " cells mapped, " <<
+        (router.mapped_bytes() >> 10) << " KiB." << std::endl;
+
+    if (argc >= 8)
+    {
+        const ShapeStore shapes((std::string(argv[1]) + "/shapes.geom").c_str());
+        std::vector<Graph::Location> points, scratch;
+        auto sink = [&points](Graph::Location l) { points.push_back(l); };
+
+        points.push_back(steps.front().loc);
+        for(std::size_t i = 1u; i < steps.size(); ++i)
+            unpack_edge(shapes, steps[i - 1].loc, steps[i].loc, steps[i].shape, scratch, sink);
+
+        if (argc == 9)
+            points = simplify(points, std::atof(argv[8]));
+
+        BufferedWriter out(argv[7]);
+        write_path(out, format_from_filename(argv[7]), points, "7f00ff00");
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include "search.hpp"
+
+SearchSpace& thread_search_space(std::size_t n)
+{
+	static thread_local std::unique_ptr<SearchSpace> space;
+	if (!space || space->cost.size() < n)
+		space.reset(new SearchSpace(n));
+	return *space;
+}
+
+ReverseView::ReverseView(const Graph &graph)
+: first_edge(graph.vertex_count() + 1, 0u), edges(graph.edge_count())
+{
+	//count in-degrees, prefix sum, scatter; shapes are walked the other way round
+	const Graph::index_t n = static_cast<Graph::index_t>(graph.vertex_count());
+
+	for(Graph::index_t v = 0u; v < n; ++v)
+	{
+		for(const Graph::Edge &e : graph.out_edges(v))
+			first_edge[e.destination + 1]++;
+	}
+	for(Graph::index_t v = 0u; v < n; ++v)
+		first_edge[v + 1] += first_edge[v];
+
+	std::vector<Graph::index_t> fill(first_edge.begin(), first_edge.end() - 1);
+	for(Graph::index_t v = 0u; v < n; ++v)
+	{
+		for(const Graph::Edge &e : graph.out_edges(v))
+		{
+			const Graph::shape_t shape = e.shape == Graph::NO_SHAPE ? e.shape : e.shape ^ Graph::SHAPE_REVERSED;
+			edges[fill[e.destination]++] = {v, shape, e.cost};
+		}
+	}
+}
+
+std::size_t ReverseView::vertex_count() const noexcept
+{
+	return first_edge.size() - 1;
+}
+
+std::size_t ReverseView::memory_usage() const noexcept
+{
+	return first_edge.capacity() * sizeof(Graph::index_t) + edges.capacity() * sizeof(Graph::Edge);
+}
+
+Landmarks::Landmarks(const Graph &graph, const ReverseView &reverse, std::size_t k)
+: chosen(), from(), to()
+{
+	const std::size_t n = graph.vertex_count();
+	if (n == 0u)
+		return;
+
+	k = std::min(k, n);
+	from.resize(n * k);
+	to.resize(n * k);
+
+	//farthest-point selection: each landmark maximises its distance to those already chosen
+	std::vector<Graph::cost_t> nearest(n, std::numeric_limits<Graph::cost_t>::infinity());
+	SearchSpace space(n);
+	NullVisitor visitor;
+
+	//start from the vertex farthest from an arbitrary one
+	search<BinaryHeap>(graph, 0u, space, ZeroHeuristic(), StopNever(), visitor);
+	Graph::index_t next = 0u;
+	for(Graph::index_t v = 0u; v < n; ++v)
+	{
+		if (space.cost[v] < std::numeric_limits<Graph::cost_t>::infinity() && space.cost[v] > space.cost[next])
+			next = v;
+	}
+	space.reset();
+
+	for(std::size_t l = 0u; l < k; ++l)
+	{
+		chosen.push_back(next);
+
+		search<BinaryHeap>(graph, next, space, ZeroHeuristic(), StopNever(), visitor);
+		for(Graph::index_t v = 0u; v < n; ++v)
+		{
+			from[v * k + l] = space.cost[v];
+			nearest[v] = std::min(nearest[v], space.cost[v]);
+		}
+		space.reset();
+
+		search<BinaryHeap>(reverse, next, space, ZeroHeuristic(), StopNever(), visitor);
+		for(Graph::index_t v = 0u; v < n; ++v)
+			to[v * k + l] = space.cost[v];
+		space.reset();
+
+		//vertices no landmark reaches would stay at infinity; only reachable ones compete
+		Graph::cost_t farthest = -1.0;
+		for(Graph::index_t v = 0u; v < n; ++v)
+		{
+			if (nearest[v] < std::numeric_limits<Graph::cost_t>::infinity() && nearest[v] > farthest)
+			{
+				farthest = nearest[v];
+				next = v;
+			}
+		}
+	}
+}
+
+const std::vector<Graph::index_t>& Landmarks::vertices() const noexcept
+{
+	return chosen;
+}
+
+std::size_t Landmarks::memory_usage() const noexcept
+{
+	return (from.capacity() + to.capacity()) * sizeof(Graph::cost_t);
+}
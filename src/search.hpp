@@ -0,0 +1,330 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "graph.hpp"
+
+//one label-setting search for every variant: the policies below are chosen at compile time and inlined,
+//so a policy that does nothing costs nothing
+
+//per-search arrays over the vertices of a view, reset() between searches that reuse them
+struct SearchSpace
+{
+	std::vector<Graph::cost_t> cost;
+	std::vector<Graph::index_t> parent;
+	//filled the first time a vertex is reached, so never initialised
+	std::unique_ptr<Graph::cost_t[]> estimate;
+	//every vertex a search gave a cost, so a reset costs what the search did rather than the graph size
+	std::vector<Graph::index_t> touched;
+
+	SearchSpace(std::size_t n)
+	: cost(n, std::numeric_limits<Graph::cost_t>::infinity()), parent(n, Graph::NO_INDEX),
+		estimate(new Graph::cost_t[n]), touched()
+	{}
+
+	void reset()
+	{
+		for(Graph::index_t v : touched)
+		{
+			cost[v] = std::numeric_limits<Graph::cost_t>::infinity();
+			parent[v] = Graph::NO_INDEX;
+		}
+		touched.clear();
+	}
+};
+
+//the calling thread's space, covering at least the given number of vertices and kept for its next search;
+//callers reset() it when done, so that search, on whichever graph, starts clean
+SearchSpace& thread_search_space(std::size_t);
+
+//heuristic policies: batch() estimates several vertices at once; 'enabled' false removes every estimate
+struct ZeroHeuristic
+{
+	constexpr static bool enabled = false;
+	void batch(const Graph::index_t*, std::size_t, Graph::cost_t*) const {}
+};
+
+//straight-line distance over the graph's speed bound; a weight above 1 trades optimality for speed
+class GreatCircleHeuristic
+{
+private:
+	const Graph &graph;
+	Graph::index_t target;
+	double weight;
+
+public:
+	constexpr static bool enabled = true;
+
+	GreatCircleHeuristic(const Graph &g, Graph::index_t t, double w = 1.0) : graph(g), target(t), weight(w) {}
+
+	void batch(const Graph::index_t *vertices, std::size_t count, Graph::cost_t *out) const
+	{
+		graph.estimate_batch(vertices, count, target, out);
+		if (weight != 1.0)
+		{
+			for(std::size_t i = 0u; i < count; ++i)
+				out[i] *= weight;
+		}
+	}
+};
+
+//the graph with every edge turned around, for searches towards a vertex
+class ReverseView
+{
+private:
+	std::vector<Graph::index_t> first_edge;
+	std::vector<Graph::Edge> edges;
+
+public:
+	ReverseView(const Graph&);
+	std::size_t vertex_count() const noexcept;
+	std::size_t memory_usage() const noexcept;
+	Graph::EdgeRange out_edges(Graph::index_t) const;
+};
+
+inline Graph::EdgeRange ReverseView::out_edges(Graph::index_t v) const
+{
+	return {edges.data() + first_edge[v], edges.data() + first_edge[v + 1]};
+}
+
+//ALT preprocessing: exact distances from and to a few far-apart vertices, stored vertex-major
+class Landmarks
+{
+private:
+	std::vector<Graph::index_t> chosen;
+	std::vector<Graph::cost_t> from; //from[v * k + l]: landmark l to v
+	std::vector<Graph::cost_t> to; //to[v * k + l]: v to landmark l
+
+public:
+	Landmarks(const Graph&, const ReverseView&, std::size_t);
+	const std::vector<Graph::index_t>& vertices() const noexcept;
+	std::size_t memory_usage() const noexcept;
+	Graph::cost_t lower_bound(Graph::index_t, Graph::index_t) const;
+};
+
+inline Graph::cost_t Landmarks::lower_bound(Graph::index_t v, Graph::index_t t) const
+{
+	//triangle inequality both ways round each landmark; unreachable pairs give NaN and are skipped
+	const std::size_t k = chosen.size();
+	const Graph::cost_t *from_v = from.data() + v * k, *from_t = from.data() + t * k;
+	const Graph::cost_t *to_v = to.data() + v * k, *to_t = to.data() + t * k;
+	Graph::cost_t best = 0.0;
+
+	for(std::size_t l = 0u; l < k; ++l)
+	{
+		const Graph::cost_t forward = from_t[l] - from_v[l];
+		const Graph::cost_t backward = to_v[l] - to_t[l];
+		if (forward > best)
+			best = forward;
+		if (backward > best)
+			best = backward;
+	}
+
+	return best;
+}
+
+class LandmarkHeuristic
+{
+private:
+	const Landmarks &landmarks;
+	Graph::index_t target;
+	double weight;
+
+public:
+	constexpr static bool enabled = true;
+
+	LandmarkHeuristic(const Landmarks &l, Graph::index_t t, double w = 1.0) : landmarks(l), target(t), weight(w) {}
+
+	void batch(const Graph::index_t *vertices, std::size_t count, Graph::cost_t *out) const
+	{
+		for(std::size_t i = 0u; i < count; ++i)
+			out[i] = weight * landmarks.lower_bound(vertices[i], target);
+	}
+};
+
+//queue policies: implicit d-ary min-heaps of (key, vertex) with lazy deletion
+template<unsigned D>
+class DaryHeap
+{
+public:
+	typedef std::pair<Graph::cost_t, Graph::index_t> Entry;
+
+private:
+	std::vector<Entry> heap;
+
+public:
+	bool empty() const noexcept
+	{
+		return heap.empty();
+	}
+
+	const Entry& top() const
+	{
+		return heap.front();
+	}
+
+	void push(Graph::cost_t key, Graph::index_t v)
+	{
+		std::size_t i = heap.size();
+		heap.emplace_back();
+		while (i > 0u && heap[(i - 1) / D].first > key)
+		{
+			heap[i] = heap[(i - 1) / D];
+			i = (i - 1) / D;
+		}
+		heap[i] = Entry(key, v);
+	}
+
+	void pop()
+	{
+		const Entry last = heap.back();
+		heap.pop_back();
+		if (heap.empty())
+			return;
+
+		std::size_t i = 0u;
+		for(;;)
+		{
+			const std::size_t first = D * i + 1;
+			if (first >= heap.size())
+				break;
+
+			std::size_t smallest = first;
+			const std::size_t end = first + D < heap.size() ? first + D : heap.size();
+			for(std::size_t c = first + 1; c < end; ++c)
+			{
+				if (heap[c].first < heap[smallest].first)
+					smallest = c;
+			}
+			if (!(heap[smallest].first < last.first))
+				break;
+
+			heap[i] = heap[smallest];
+			i = smallest;
+		}
+		heap[i] = last;
+	}
+};
+
+typedef DaryHeap<2> BinaryHeap;
+typedef DaryHeap<4> QuaternaryHeap;
+
+//stopping criteria, checked as each vertex is settled
+struct StopAtTarget
+{
+	Graph::index_t target;
+	bool operator()(Graph::index_t v, Graph::cost_t) const { return v == target; }
+};
+
+struct StopAtCost
+{
+	Graph::cost_t limit;
+	bool operator()(Graph::index_t, Graph::cost_t d) const { return d > limit; }
+};
+
+struct StopNever
+{
+	bool operator()(Graph::index_t, Graph::cost_t) const { return false; }
+};
+
+//visitor hooks for instrumentation
+struct NullVisitor
+{
+	void settled(Graph::index_t, Graph::cost_t) {}
+	void relaxed(Graph::index_t, const Graph::Edge&, Graph::cost_t) {}
+};
+
+struct CountingVisitor
+{
+	std::size_t settled_count = 0u;
+	std::size_t relaxed_count = 0u;
+
+	void settled(Graph::index_t, Graph::cost_t) { settled_count++; }
+	void relaxed(Graph::index_t, const Graph::Edge&, Graph::cost_t) { relaxed_count++; }
+};
+
+//searches out_edges() of the view from source until stop() accepts a settled vertex, which is returned;
+//NO_INDEX once everything reachable is settled. Costs and parents are left in space.
+template<typename Queue, typename View, typename Heuristic, typename Stop, typename Visitor>
+inline Graph::index_t search(const View &view, Graph::index_t source, SearchSpace &space,
+	const Heuristic &heuristic, const Stop &stop, Visitor &visitor)
+{
+	constexpr Graph::cost_t INFINITE_COST = std::numeric_limits<Graph::cost_t>::infinity();
+	std::vector<Graph::cost_t> &cost = space.cost;
+	std::vector<Graph::index_t> &parent = space.parent;
+	std::vector<Graph::index_t> &touched = space.touched;
+	Graph::cost_t *estimate = space.estimate.get();
+
+	Queue frontier;
+	std::vector<Graph::index_t> pending;
+	std::vector<Graph::cost_t> batch;
+
+	cost[source] = 0.0;
+	touched.push_back(source);
+	if constexpr (Heuristic::enabled)
+		heuristic.batch(&source, 1u, estimate + source);
+	frontier.push(Heuristic::enabled ? estimate[source] : 0.0, source);
+
+	while (!frontier.empty())
+	{
+		const Graph::cost_t key = frontier.top().first;
+		const Graph::index_t current = frontier.top().second;
+		frontier.pop();
+
+		//an entry superseded by a cheaper push; keys are recomputed exactly as they were pushed
+		const Graph::cost_t g = cost[current];
+		if constexpr (Heuristic::enabled)
+		{
+			if (key > g + estimate[current])
+				continue;
+		}
+		else if (key > g)
+			continue;
+
+		visitor.settled(current, g);
+		if (stop(current, g))
+			return current;
+
+		if constexpr (Heuristic::enabled)
+		{
+			//neighbours reached for the first time are estimated together
+			pending.clear();
+			for(const Graph::Edge &edge : view.out_edges(current))
+			{
+				if (cost[edge.destination] == INFINITE_COST)
+					pending.push_back(edge.destination);
+			}
+			batch.resize(pending.size());
+			heuristic.batch(pending.data(), pending.size(), batch.data());
+			for(std::size_t i = 0u; i < pending.size(); ++i)
+				estimate[pending[i]] = batch[i];
+		}
+
+		for(const Graph::Edge &edge : view.out_edges(current))
+		{
+			const Graph::cost_t new_cost = g + edge.cost;
+
+			if (new_cost < cost[edge.destination])
+			{
+				if (cost[edge.destination] == INFINITE_COST)
+					touched.push_back(edge.destination);
+				cost[edge.destination] = new_cost;
+				parent[edge.destination] = current;
+				visitor.relaxed(current, edge, new_cost);
+
+				if constexpr (Heuristic::enabled)
+					frontier.push(new_cost + estimate[edge.destination], edge.destination);
+				else
+					frontier.push(new_cost, edge.destination);
+			}
+		}
+	}
+
+	return Graph::NO_INDEX;
+}
+
+#endif //SEARCH_HPP
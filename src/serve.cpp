@@ -0,0 +1,124 @@
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "query_service.hpp"
+
+//answers queries read from standard input, one per line, in order:
+//  lat1 lon1 lat2 lon2   route between two coordinates
+//  reload file           swap in another graph file
+//  stats                 print cache and latency statistics
+static void print_route(const QueryService::RoutePtr &route)
+{
+    if (route->found)
+        std::cout << "cost " << route->cost << ", " << route->path.size() << " vertices" << std::endl;
+    else
+        std::cout << "not found" << std::endl;
+}
+
+static void print_statistics(QueryService &service)
+{
+    const QueryService::Statistics s = service.statistics();
+    const double requests = s.requests > 0u ? static_cast<double>(s.requests) : 1.0;
+
+    std::cout << "Requests " << s.requests << ": " << s.hits << " cache hits (" << 100.0 * s.hits / requests <<
+        "%), " << s.coalesced << " coalesced (" << 100.0 * s.coalesced / requests << "%), " << s.computed <<
+        " computed; " << s.cached_routes << " routes cached." << std::endl;
+    std::cout << "Latency p50 " << 1e3 * s.p50 << "ms, p90 " << 1e3 * s.p90 << "ms, p99 " << 1e3 * s.p99 <<
+        "ms, max " << 1e3 * s.max << "ms." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::cerr << "1/2/3 arguments expected: file_input, (optional : threads), (optional : snapping resolution in degrees)";
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    const double resolution = argc > 3 ? std::atof(argv[3]) : 1e-4;
+
+    if (!(resolution >= 1e-7))
+    {
+        std::cerr << "Enter a snapping resolution of at least 1e-7 degrees.";
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<QueryService> service_ptr;
+    try
+    {
+        service_ptr.reset(new QueryService(argv[1], threads, resolution));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << ".";
+        return EXIT_FAILURE;
+    }
+    QueryService &service = *service_ptr;
+    std::deque<std::shared_future<QueryService::RoutePtr>> pending;
+    std::string line;
+
+    //queries are all submitted at once; answers are printed in input order as they become ready
+    auto drain = [&pending](bool wait)
+    {
+        while (!pending.empty() &&
+            (wait || pending.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+        {
+            try
+            {
+                print_route(pending.front().get());
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "error: " << e.what() << std::endl;
+            }
+            pending.pop_front();
+        }
+    };
+
+    while (std::getline(std::cin, line))
+    {
+        std::istringstream words(line);
+        std::string first;
+        if (!(words >> first))
+            continue;
+
+        if (first == "reload")
+        {
+            std::string filename;
+            words >> filename;
+            drain(true);
+            try
+            {
+                service.reload(filename.c_str());
+                std::cout << "reloaded " << filename << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "error: " << e.what() << ", still serving the previous graph" << std::endl;
+            }
+        }
+        else if (first == "stats")
+        {
+            drain(true);
+            print_statistics(service);
+        }
+        else
+        {
+            Graph::Location from, to;
+            std::istringstream coordinates(line);
+            if (coordinates >> from.lat >> from.lon >> to.lat >> to.lon)
+                pending.push_back(service.route(from, to));
+            else
+                std::cerr << "Skipped malformed line: " << line << std::endl;
+        }
+
+        drain(false);
+    }
+
+    drain(true);
+    print_statistics(service);
+
+    return EXIT_SUCCESS;
+}